@@ -0,0 +1,653 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "JsonParser.h"
+#include "JsonWriter.h"
+#include "JsonDocument.h"
+#include "JsonPushParser.h"
+#include "JsonLinesParser.h"
+#include "JsonArrayParser.h"
+#include "JsonLazyDocument.h"
+#include "JsonPointer.h"
+
+using namespace std::string_literals;
+using namespace MyJson;
+
+// ========================================= A Simple Benchmark Framework =============================================================
+// run func until at least minSeconds passed, report the best round
+static double measure(const std::function<void()>& func, double minSeconds = 0.5)
+{
+	using Clock = std::chrono::steady_clock;
+	double best = 1e100, total = 0;
+	while (total < minSeconds)
+	{
+		auto start = Clock::now();
+		func();
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		total += seconds;
+		if (seconds < best)
+			best = seconds;
+	}
+	return best;
+}
+
+static void report(const char* name, size_t bytes, double seconds)
+{
+	printf("%-40s %10.3f ms %10.1f MB/s\n", name, seconds * 1000, bytes / seconds / 1024 / 1024);
+}
+
+static void reportOps(const char* name, size_t count, double seconds)
+{
+	printf("%-40s %10.3f ms %10.1f ns/op\n", name, seconds * 1000, seconds * 1e9 / count);
+}
+
+static void benchParse(const char* name, const std::string& json, ParseEngine engine = eRecursiveEngine, bool borrow = false)
+{
+	JsonParser parser;
+	parser.setParseEngine(engine);
+	parser.setBorrowStrings(borrow);
+	JsonValue value;
+	int ret = eOk;
+	double seconds = measure([&]() { ret = parser.parseJson(value, json); });
+	if (ret != eOk)
+		printf("%s: parse failed: %d\n", name, ret);
+	report(name, json.size(), seconds);
+}
+
+// a document per round, as a request handler would do: parse, then drop the whole tree
+static void benchParseDocument(const char* name, const std::string& json, bool borrow = false)
+{
+	JsonParser parser;
+	parser.setBorrowStrings(borrow);
+	int ret = eOk;
+	double seconds = measure([&]() {
+		JsonDocument doc;
+		ret = parser.parseJson(doc, json);
+	});
+	if (ret != eOk)
+		printf("%s: parse failed: %d\n", name, ret);
+	report(name, json.size(), seconds);
+}
+
+// the buffer is restored from json before every round, the copy is included in the time
+static void benchParseInSitu(const char* name, const std::string& json)
+{
+	JsonParser parser;
+	JsonValue value;
+	std::string buf(json.size(), '\0');
+	int ret = eOk;
+	double seconds = measure([&]() {
+		memcpy(&buf[0], json.data(), json.size());
+		ret = parser.parseJsonInSitu(value, &buf[0], buf.size());
+	});
+	if (ret != eOk)
+		printf("%s: parse failed: %d\n", name, ret);
+	report(name, json.size(), seconds);
+}
+
+// the text arrives in chunks of chunkSize bytes
+static void benchPushParse(const char* name, const std::string& json, size_t chunkSize)
+{
+	JsonPushParser parser;
+	JsonValue value;
+	int ret = eOk;
+	double seconds = measure([&]() {
+		for (size_t pos = 0; pos < json.size(); pos += chunkSize)
+			parser.feed(json.data() + pos, std::min(chunkSize, json.size() - pos));
+		ret = parser.finish(value);
+	});
+	if (ret != eOk)
+		printf("%s: parse failed: %d\n", name, ret);
+	report(name, json.size(), seconds);
+}
+
+// sums the numbers of a document, nothing else is kept
+class SumHandler
+{
+public:
+	double sum = 0;
+	void null() {}
+	void boolean(bool) {}
+	void number(double d) { sum += d; }
+	void int64(int64_t i) { sum += double(i); }
+	void uint64(uint64_t u) { sum += double(u); }
+	void string(std::string_view) {}
+	void startObject() {}
+	void key(std::string_view) {}
+	void endObject(size_t) {}
+	void startArray() {}
+	void endArray(size_t) {}
+};
+
+static void benchParseEvents(const char* name, const std::string& json)
+{
+	JsonParser parser;
+	SumHandler handler;
+	int ret = eOk;
+	double seconds = measure([&]() { ret = parser.parseEvents(handler, json); });
+	if (ret != eOk)
+		printf("%s: parse failed: %d\n", name, ret);
+	report(name, json.size(), seconds);
+}
+
+static void benchValidate(const char* name, const std::string& json)
+{
+	JsonParser parser;
+	int ret = eOk;
+	double seconds = measure([&]() { ret = parser.validate(json); });
+	if (ret != eOk)
+		printf("%s: validate failed: %d\n", name, ret);
+	report(name, json.size(), seconds);
+}
+
+// ========================================= A Simple Benchmark Framework =============================================================
+
+// a config dump like document: records of short strings, numbers, flags and nested arrays
+static JsonValue makeDocument(int records)
+{
+	JsonValue root;
+	for (int i = 0; i < records; i++)
+	{
+		JsonValue record;
+		record["id"] = i;
+		record["name"] = "service-"s + std::to_string(i);
+		record["enabled"] = (i % 3 != 0);
+		record["weight"] = i * 0.25;
+		record["owner"] = JsonValue::sNullValue;
+		JsonValue& ports = record["ports"];
+		for (int j = 0; j < 4; j++)
+			ports.append(8000 + i % 100 + j);
+		JsonValue& limits = record["limits"];
+		limits["cpu"] = 0.5 + i % 8;
+		limits["memory"] = "512Mi";
+		limits["tags"].append("prod");
+		limits["tags"].append("east");
+		root.append(record);
+	}
+	return root;
+}
+
+static void bench_white_space()
+{
+	JsonValue root = makeDocument(20000);
+	std::string minified, tabs, spaces;
+
+	JsonWriter writer(false);
+	writer.writeJson(root, minified);
+
+	writer.setWithStyle(true);
+	writer.writeJson(root, tabs);
+
+	writer.setUseSpacesToIndent();
+	writer.setIndentSpaceCount(8);
+	writer.setLFStyle(eLF);
+	writer.writeJson(root, spaces);
+
+	printf("white space skipping (%zu bytes minified, %zu bytes indented with tabs, %zu bytes indented with spaces):\n",
+		minified.size(), tabs.size(), spaces.size());
+	benchParse("minified", minified);
+	benchParse("indented with tabs, CRLF", tabs);
+	benchParse("indented with 8 spaces, LF", spaces);
+
+	// deeply nested leaves, mostly indentation
+	JsonValue deep = 0;
+	for (int level = 0; level < 12; level++)
+	{
+		JsonValue parent;
+		parent.append(deep);
+		parent.append(deep);
+		deep = std::move(parent);
+	}
+	std::string deepSpaces;
+	writer.setRewriteString();
+	writer.writeJson(deep, deepSpaces);
+	benchParse("deeply nested, 8 spaces, LF", deepSpaces);
+}
+
+static void bench_engines()
+{
+	JsonValue root = makeDocument(20000);
+	std::string minified, indented;
+	JsonWriter writer(false);
+	writer.writeJson(root, minified);
+	writer.setWithStyle(true);
+	writer.writeJson(root, indented);
+
+	printf("parse engines:\n");
+	benchParse("recursive, minified", minified, eRecursiveEngine);
+	benchParse("structural index, minified", minified, eStructuralIndexEngine);
+	benchParse("iterative, minified", minified, eIterativeEngine);
+	benchParse("recursive, indented", indented, eRecursiveEngine);
+	benchParse("structural index, indented", indented, eStructuralIndexEngine);
+	benchParse("iterative, indented", indented, eIterativeEngine);
+	benchParseEvents("events, minified", minified);
+	benchValidate("validate, minified", minified);
+	benchValidate("validate, indented", indented);
+	benchPushParse("push, 64KB chunks, minified", minified, 64 * 1024);
+	benchPushParse("push, 1KB chunks, minified", minified, 1024);
+	benchParseInSitu("in situ, minified", minified);
+	benchParse("borrowed strings, minified", minified, eRecursiveEngine, true);
+	benchParseDocument("document, minified", minified);
+	benchParseDocument("document, borrowed strings, minified", minified, true);
+}
+
+static void bench_numbers()
+{
+	// geo coordinate arrays: [[lon, lat], ...]
+	std::string coordinates = "[";
+	unsigned int seed = 42;
+	for (int i = 0; i < 200000; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		double lon = (seed % 3600000) / 10000.0 - 180.0;
+		seed = seed * 1103515245 + 12345;
+		double lat = (seed % 1800000) / 10000.0 - 90.0;
+		char buf[64];
+		snprintf(buf, sizeof(buf), "%s[%.6f,%.6f]", i ? "," : "", lon, lat);
+		coordinates += buf;
+	}
+	coordinates += "]";
+
+	printf("numbers:\n");
+	benchParse("geo coordinates", coordinates);
+	benchParseEvents("geo coordinates, events summed", coordinates);
+}
+
+static void bench_strings()
+{
+	// base64 blobs and log messages
+	static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	JsonValue root;
+	unsigned int seed = 7;
+	for (int i = 0; i < 2000; i++)
+	{
+		std::string blob, message;
+		for (int j = 0; j < 4096; j++)
+		{
+			seed = seed * 1103515245 + 12345;
+			blob += base64[(seed >> 16) % 64];
+		}
+		for (int j = 0; j < 40; j++)
+			message += "GET /api/v1/items?id=" + std::to_string(i * 40 + j) + " 200 OK; ";
+		JsonValue record;
+		record["blob"] = blob;
+		record["message"] = message;
+		root.append(std::move(record));
+	}
+	std::string json;
+	JsonWriter writer(false);
+	writer.writeJson(root, json);
+
+	printf("long strings:\n");
+	std::string copy(json.size(), '\0');
+	double seconds = measure([&]() { memcpy(&copy[0], json.data(), json.size()); });
+	report("memcpy of the same bytes", json.size(), seconds);
+	benchParse("parse", json);
+	benchParseInSitu("parse in situ (with buffer copy)", json);
+	benchParse("parse with borrowed strings", json, eRecursiveEngine, true);
+
+	// UTF-8 text, every string goes through the validation
+	JsonValue texts;
+	for (int i = 0; i < 20000; i++)
+	{
+		std::string text;
+		for (int j = 0; j < 20; j++)
+			text += "一个C++ Json解析库，第" + std::to_string(i * 20 + j) + "条记录 ✓ 😀 ";
+		texts.append(text);
+	}
+	std::string text;
+	writer.writeJson(texts, text);
+	JsonParser parser;
+	JsonValue value;
+	for (bool validate : { true, false })
+	{
+		parser.setValidateUtf8(validate);
+		int ret = eOk;
+		seconds = measure([&]() { ret = parser.parseJson(value, text); });
+		if (ret != eOk)
+			printf("parse UTF-8 text: parse failed: %d\n", ret);
+		report(validate ? "parse UTF-8 text" : "parse UTF-8 text without validation", text.size(), seconds);
+	}
+}
+
+static void bench_lines()
+{
+	// access log records, one per line
+	std::string text;
+	JsonWriter writer(false);
+	JsonValue record;
+	for (int i = 0; i < 200000; i++)
+	{
+		record["ts"] = int64_t(1700000000000) + i;
+		record["method"] = i % 5 ? "GET" : "POST";
+		record["path"] = "/api/v1/items/"s + std::to_string(i % 977);
+		record["status"] = i % 13 ? 200 : 404;
+		record["latency"] = (i % 1000) * 0.125;
+		writer.writeJson(record, text);
+		text += "\n";
+	}
+
+	printf("JSON lines (%zu bytes, hardware threads: %u):\n", text.size(), std::thread::hardware_concurrency());
+	JsonParser parser;
+	std::vector<JsonValue> values;
+	double seconds = measure([&]() {
+		values.clear();
+		std::string line;
+		for (size_t pos = 0; pos < text.size();)
+		{
+			size_t end = text.find('\n', pos);
+			line.assign(text, pos, end - pos);
+			parser.parseJson(values.emplace_back(), line);
+			pos = end + 1;
+		}
+	});
+	report("one thread, line by line", text.size(), seconds);
+	for (unsigned int threads : { 1u, 2u, 4u, 0u })
+	{
+		JsonLinesParser linesParser(threads);
+		std::vector<JsonLineResult> results;
+		size_t failed = 0;
+		seconds = measure([&]() { failed = linesParser.parse(text, values, results); });
+		if (failed != 0)
+			printf("%zu records failed\n", failed);
+		std::string name = "JsonLinesParser, "s + std::to_string(linesParser.threadCount()) + " threads";
+		report(name.c_str(), text.size(), seconds);
+	}
+}
+
+static void bench_large_array()
+{
+	std::string json;
+	JsonWriter writer(false);
+	writer.writeJson(makeDocument(100000), json);
+
+	printf("large array (%zu bytes, hardware threads: %u):\n", json.size(), std::thread::hardware_concurrency());
+	benchParse("JsonParser", json);
+	for (unsigned int threads : { 1u, 2u, 4u, 0u })
+	{
+		JsonArrayParser arrayParser(threads);
+		JsonValue value;
+		int ret = eOk;
+		double seconds = measure([&]() { ret = arrayParser.parseJson(value, json); });
+		if (ret != eOk)
+			printf("parse failed: %d\n", ret);
+		std::string name = "JsonArrayParser, "s + std::to_string(arrayParser.threadCount()) + " threads";
+		report(name.c_str(), json.size(), seconds);
+	}
+}
+
+// a request handler reading 4 fields out of a 50KB body
+static void bench_lazy()
+{
+	JsonValue body;
+	body["items"] = makeDocument(250);
+	body["user"]["id"] = 42;
+	body["user"]["name"] = "someone";
+	body["trace"] = "0af7651916cd43dd8448eb211c80319c";
+	std::string json;
+	JsonWriter writer(false);
+	writer.writeJson(body, json);
+
+	printf("read 4 fields (%zu bytes):\n", json.size());
+	JsonParser parser;
+	size_t total = 0;
+	double seconds = measure([&]() {
+		JsonValue value;
+		parser.parseJson(value, json);
+		total += value["user"s]["id"s].getInt64() + value["user"s]["name"s].getStringView().size()
+			+ value["trace"s].getStringView().size() + value["items"s][100]["name"s].getStringView().size();
+	});
+	report("parseJson, then read", json.size(), seconds);
+	JsonLazyDocument doc;
+	seconds = measure([&]() {
+		doc.reset(json);
+		total += doc["user"]["id"].getInt64() + doc["user"]["name"].getStringView().size()
+			+ doc["trace"].getStringView().size() + doc["items"][100]["name"].getStringView().size();
+	});
+	report("JsonLazyDocument", json.size(), seconds);
+	if (total == 0)
+		printf("nothing read\n");
+}
+
+// from a file to a value and back, the file is in the page cache after the first round
+static void bench_file()
+{
+	std::string json;
+	JsonWriter writer(false);
+	writer.writeJson(makeDocument(100000), json);
+	const char* path = "benchmark_file.json";
+	FILE* file = fopen(path, "wb");
+	if (file == NULL || fwrite(json.data(), 1, json.size(), file) != json.size())
+	{
+		printf("can not write %s\n", path);
+		if (file)
+			fclose(file);
+		return;
+	}
+	fclose(file);
+
+	printf("file (%zu bytes):\n", json.size());
+	JsonParser parser;
+	int ret = eOk;
+	double seconds = measure([&]() {
+		JsonValue value;
+		std::string text;
+		FILE* in = fopen(path, "rb");
+		char buf[64 * 1024];
+		while (size_t n = fread(buf, 1, sizeof(buf), in))
+			text.append(buf, n);
+		fclose(in);
+		ret = parser.parseJson(value, text);
+	});
+	if (ret != eOk)
+		printf("parse failed: %d\n", ret);
+	report("read into a string, then parseJson", json.size(), seconds);
+	seconds = measure([&]() {
+		JsonValue value;
+		ret = parser.parseFile(value, path);
+	});
+	if (ret != eOk)
+		printf("parse failed: %d\n", ret);
+	report("parseFile", json.size(), seconds);
+	remove(path);
+}
+
+static void bench_objects()
+{
+	std::string json;
+	JsonWriter writer(false);
+	writer.writeJson(makeDocument(20000), json);
+	JsonValue root;
+	JsonParser parser;
+	parser.parseJson(root, json);
+
+	printf("objects:\n");
+	static const std::string keys[] = { "id", "name", "enabled", "weight", "owner", "ports", "limits" };
+	size_t found = 0;
+	double seconds = measure([&]() {
+		for (size_t i = 0; i < root.size(); i++)
+			for (const std::string& key : keys)
+				found += root[i].containsKey(key);
+	});
+	reportOps("lookup in 7 member objects", root.size() * 7, seconds);
+
+	JsonValue large;
+	std::vector<std::string> largeKeys;
+	for (int i = 0; i < 10000; i++)
+	{
+		largeKeys.push_back("key-"s + std::to_string(i));
+		large[largeKeys.back()] = i;
+	}
+	seconds = measure([&]() {
+		for (const std::string& key : largeKeys)
+			found += large.containsKey(key);
+	});
+	reportOps("lookup in a 10000 member object", largeKeys.size(), seconds);
+	if (found == 0)
+		printf("nothing found\n");
+}
+
+// the same dozen paths looked up in every message
+static void bench_pointers()
+{
+	JsonValue message;
+	for (int i = 0; i < 30; i++)
+		message["header"]["x-field-"s + std::to_string(i)] = i;
+	message["header"]["route"]["service"] = "orders";
+	message["header"]["route"]["method"] = "create";
+	message["header"]["route"]["version"] = 2;
+	message["header"]["tenant"] = "acme";
+	message["body"] = makeDocument(10);
+	const std::vector<std::string> paths = { "/header/route/service", "/header/route/method", "/header/route/version",
+		"/header/tenant", "/header/x-field-3", "/header/x-field-27", "/body/0/id", "/body/0/name", "/body/5/owner/name",
+		"/body/9/ports/0", "/body/9/limits/cpu", "/missing/route" };
+
+	printf("%zu pointers:\n", paths.size());
+	size_t found = 0;
+	const size_t rounds = 10000;
+	// what a caller does without compiled pointers: split the path into keys at every lookup
+	double seconds = measure([&]() {
+		for (size_t r = 0; r < rounds; r++)
+			for (const std::string& path : paths)
+			{
+				const JsonValue* value = &message;
+				for (size_t pos = 1; value && pos <= path.size(); )
+				{
+					size_t end = std::min(path.find('/', pos), path.size());
+					std::string key = path.substr(pos, end - pos);
+					if (value->isObject())
+						value = value->containsKey(key) ? &value->get(key) : nullptr;
+					else if (value->isArray())
+						value = std::stoul(key) < value->size() ? &value->get(std::stoul(key)) : nullptr;
+					else
+						value = nullptr;
+					pos = end + 1;
+				}
+				found += value != nullptr;
+			}
+	});
+	reportOps("split the path per lookup", rounds * paths.size(), seconds);
+
+	std::vector<JsonPointer> pointers(paths.begin(), paths.end());
+	seconds = measure([&]() {
+		for (size_t r = 0; r < rounds; r++)
+			for (const JsonPointer& pointer : pointers)
+				found += pointer.resolve(message) != nullptr;
+	});
+	reportOps("JsonPointer", rounds * paths.size(), seconds);
+
+	JsonPointerBatch batch;
+	for (const std::string& path : paths)
+		batch.add(path);
+	std::vector<const JsonValue*> results;
+	seconds = measure([&]() {
+		for (size_t r = 0; r < rounds; r++)
+		{
+			batch.resolve(message, results);
+			found += results[0] != nullptr;
+		}
+	});
+	reportOps("JsonPointerBatch", rounds * paths.size(), seconds);
+	if (found == 0)
+		printf("nothing found\n");
+}
+
+// 8 fields out of events with 200 members
+static void bench_projection()
+{
+	JsonValue events;
+	for (int i = 0; i < 1000; i++)
+	{
+		JsonValue event;
+		for (int j = 0; j < 200; j++)
+			event["attribute-"s + std::to_string(j)] = j % 2 ? JsonValue("value-"s + std::to_string(i * j)) : JsonValue(i * j * 0.5);
+		event["user"]["id"] = i;
+		event["user"]["country"] = "de";
+		events.append(event);
+	}
+	std::string json;
+	JsonWriter writer(false);
+	writer.writeJson(events, json);
+
+	printf("projection of 8 fields (%zu bytes):\n", json.size());
+	benchParse("parseJson", json);
+	JsonPointerBatch paths;
+	for (int i = 0; i < 1000; i += 200)
+		paths.add("/" + std::to_string(i) + "/attribute-7");
+	paths.add("/999/attribute-100");
+	paths.add("/999/user/id");
+	paths.add("/999/user/country");
+	JsonParser parser;
+	parser.setProjection(&paths);
+	JsonValue value;
+	int ret = eOk;
+	double seconds = measure([&]() { ret = parser.parseJson(value, json); });
+	if (ret != eOk)
+		printf("projection: parse failed: %d\n", ret);
+	report("parseJson with a projection", json.size(), seconds);
+}
+
+// the same message shape parsed over and over, as a message loop does
+static void bench_reuse()
+{
+	std::vector<std::string> messages;
+	JsonWriter writer(false);
+	for (int i = 0; i < 100; i++)
+	{
+		JsonValue message;
+		message["header"]["request-id"] = "req-"s + std::to_string(i) + "-7f3a9c2e-41d8-4b6e-9a0f-5c1e8d2b7a64";
+		message["header"]["user-agent"] = "client/2.1 (linux; x86_64)";
+		message["body"] = makeDocument(10);
+		messages.emplace_back();
+		writer.writeJson(message, messages.back());
+	}
+	size_t bytes = 0;
+	for (const std::string& message : messages)
+		bytes += message.size();
+
+	printf("100 messages of the same shape (%zu bytes):\n", bytes);
+	for (bool reuse : { false, true })
+	{
+		JsonParser parser;
+		parser.setReuseValues(reuse);
+		JsonValue value;
+		int ret = eOk;
+		double seconds = measure([&]() {
+			for (const std::string& message : messages)
+				ret |= parser.parseJson(value, message);
+		});
+		if (ret != eOk)
+			printf("reuse: parse failed: %d\n", ret);
+		report(reuse ? "parse into the value, reusing its storage" : "parse into the value", bytes, seconds);
+	}
+}
+
+int main()
+{
+#if defined(MYJSON_NO_SIMD)
+	printf("build: no SIMD\n");
+#elif defined(__AVX2__)
+	printf("build: AVX2\n");
+#else
+	printf("build: SSE2 or portable\n");
+#endif
+	printf("sizeof(JsonValue): %zu\n", sizeof(JsonValue));
+	bench_white_space();
+	bench_engines();
+	bench_numbers();
+	bench_strings();
+	bench_lines();
+	bench_large_array();
+	bench_file();
+	bench_lazy();
+	bench_objects();
+	bench_pointers();
+	bench_projection();
+	bench_reuse();
+	return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef _JSON_ARRAY_PARSER_H_
+#define _JSON_ARRAY_PARSER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "JsonParser.h"
+
+namespace MyJson
+{
+
+class ThreadPool;
+
+// parses a large text whose root is an array on a pool of threads:
+// a structural pre-scan finds where the elements are, then the elements are parsed in parallel into the array.
+// other roots, small texts and texts with an error are parsed by one JsonParser, so the result, the error and its
+// position are always the same as JsonParser's.
+class JsonArrayParser
+{
+public:
+	explicit JsonArrayParser(unsigned int threadCount = 0); // threads parsing elements, the caller included, 0 for one per core
+	~JsonArrayParser();
+
+	JsonArrayParser(const JsonArrayParser&) = delete;
+	JsonArrayParser& operator=(const JsonArrayParser&) = delete;
+
+	int parseJson(JsonValue& value, std::string_view json);
+	int parseJson(JsonValue& value, std::string_view json, std::string& errLoc);
+	int errorLine();
+	int errorColumn();
+	unsigned int threadCount() const;
+	void setParseLFStyle(LFStyle style);
+	void setMaxDepth(size_t depth);
+	void setValidateUtf8(bool validate);
+
+	static constexpr size_t kMinParallelSize = 64 * 1024; // smaller texts are not worth the threads
+
+private:
+	int parseElements(JsonValue& value, std::string_view json);
+
+	std::unique_ptr<ThreadPool> m_pool;
+	std::vector<JsonParser> m_parsers; // one per thread, the first one also splits the array and parses serially
+	std::vector<size_t> m_separators; // offsets of the '[', ',' and ']' of the root array
+	std::string m_errInfo;
+};
+
+}
+#endif
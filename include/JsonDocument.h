@@ -0,0 +1,42 @@
+#ifndef _JSON_DOCUMENT_H_
+#define _JSON_DOCUMENT_H_
+
+#include <memory_resource>
+#include "JsonValue.h"
+
+namespace MyJson
+{
+
+// a value tree that allocates from its own monotonic arena
+// parsing into a document is bump allocation, and the arena is released at once when the document is cleared or destroyed.
+// arrays and objects of the tree allocate from the arena, strings and keys are views of characters in the arena.
+// a copy of a value taken out of the document still refers to the arena for its strings, it must not outlive the document.
+class JsonDocument
+{
+public:
+	JsonDocument();
+	explicit JsonDocument(size_t initialSize, std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+	~JsonDocument();
+
+	JsonDocument(const JsonDocument&) = delete;
+	JsonDocument& operator=(const JsonDocument&) = delete;
+
+	// the tree a parse builds lives in the arena alone, clear and the destructor then drop it without visiting its nodes.
+	// root reads the tree. mutableRoot is the way to change it: a change may put heap strings or containers of
+	// other resources in the tree, so the tree is destroyed node by node once after mutableRoot is called.
+	const JsonValue& root() const;
+	JsonValue& mutableRoot();
+	std::pmr::memory_resource* resource();
+	void clear();
+
+private:
+	friend class JsonParser; // parses into m_root, the result is arena only
+	friend class JsonPointer; // creates paths in the arena, the tree stays arena only
+
+	std::pmr::monotonic_buffer_resource m_arena; // declared first, destroyed after the tree
+	JsonValue m_root;
+	bool m_bArenaOnly; // no storage of the tree is outside the arena
+};
+
+}
+#endif
@@ -0,0 +1,90 @@
+#ifndef _JSON_LAZY_DOCUMENT_H_
+#define _JSON_LAZY_DOCUMENT_H_
+
+#include <string>
+#include <string_view>
+#include "JsonParser.h"
+
+namespace MyJson
+{
+
+class JsonLazyDocument;
+
+// a value in the text of a JsonLazyDocument, nothing is parsed until it is read.
+// a cursor for a key or index that is not there does not exist, and every cursor taken from it does not exist either.
+// the values read are the same as JsonParser gives for the same text; errors are only found where the text is read.
+class JsonCursor
+{
+public:
+	JsonCursor(); // does not exist
+
+	bool exists() const;
+	int result() const; // eOk, or the error in the text on the way to this value or in the value once it is read
+	ValueType type() const; // eNull if it does not exist or is a number whose text is not valid
+	bool isNull() const;
+	bool isBool() const;
+	bool isNumber() const;
+	bool isString() const;
+	bool isArray() const;
+	bool isObject() const;
+
+	// false, 0 or an empty string if it is not of that type or the text of the value is not valid,
+	// result() tells them apart: it stays eOk for another type and gets the error of a value that is not valid
+	bool getBool() const;
+	double getNumber() const;
+	int64_t getInt64() const;
+	uint64_t getUint64() const;
+	std::string getString() const;
+	std::string_view getStringView() const; // refers to the text if there is no escape, otherwise valid until the document reads another string
+
+	size_t size() const; // elements or members in the text, found by skipping them
+	bool containsKey(std::string_view key) const;
+	JsonCursor operator[](std::string_view key) const; // the last member with the key, as JsonValue keeps it
+	JsonCursor operator[](size_t index) const; // skips the elements before it
+	int parse(JsonValue& value) const; // the whole value, fully checked
+
+private:
+	friend class JsonLazyDocument;
+	JsonCursor(JsonLazyDocument* pDoc, const char* pValue, int result);
+	int read(JsonValue& value) const;
+	int readString(std::string_view& str) const;
+
+	JsonLazyDocument* m_pDoc;
+	const char* m_pValue; // first character of the value, NULL if it does not exist
+	mutable int m_result; // a read keeps its error here
+};
+
+// reads a few values out of a large text without building a JsonValue for all of it:
+// the subtrees on the way to them are skipped by a scan that only looks at quotes and brackets.
+// the text must outlive the document and its cursors, a document is used by one thread at a time.
+class JsonLazyDocument
+{
+public:
+	explicit JsonLazyDocument(std::string_view json = std::string_view());
+	~JsonLazyDocument();
+
+	JsonLazyDocument(const JsonLazyDocument&) = delete;
+	JsonLazyDocument& operator=(const JsonLazyDocument&) = delete;
+
+	void reset(std::string_view json); // another text, cursors of the previous text are invalid
+	JsonCursor root();
+	JsonCursor operator[](std::string_view key);
+	JsonCursor operator[](size_t index);
+	void setMaxDepth(size_t depth); // of JsonCursor::parse
+
+private:
+	friend class JsonCursor;
+
+	int readValue(const char* pValue, JsonValue& value);
+	int readString(const char* pValue, std::string_view& str);
+	int readEnd() const;
+	JsonCursor findMember(const char* pObject, std::string_view key);
+	JsonCursor findElement(const char* pArray, size_t index);
+	size_t count(const char* pContainer);
+
+	std::string_view m_json;
+	JsonParser m_parser; // its input is always m_json
+};
+
+}
+#endif
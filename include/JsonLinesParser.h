@@ -0,0 +1,61 @@
+#ifndef _JSON_LINES_PARSER_H_
+#define _JSON_LINES_PARSER_H_
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "JsonParser.h"
+
+namespace MyJson
+{
+
+class ThreadPool;
+
+struct JsonLineResult
+{
+	int result;	// ParseResult of the record
+	int line;	// line of the record in the text, from 1
+	int column;	// column of the error in the record, 0 if there is none
+};
+
+// parses newline delimited JSON (NDJSON / JSON Lines) on a pool of threads, each with its own JsonParser.
+// every line that is not blank is a record, records are parsed in parallel and come back in the order of the text.
+class JsonLinesParser
+{
+public:
+	explicit JsonLinesParser(unsigned int threadCount = 0); // threads parsing records, the caller included, 0 for one per core
+	~JsonLinesParser();
+
+	JsonLinesParser(const JsonLinesParser&) = delete;
+	JsonLinesParser& operator=(const JsonLinesParser&) = delete;
+
+	// a value and a result for each record, returns the number of records that failed
+	size_t parse(std::string_view text, std::vector<JsonValue>& values, std::vector<JsonLineResult>& results);
+	unsigned int threadCount() const;
+	void setParseEngine(ParseEngine engine);
+	void setMaxDepth(size_t depth);
+	void setValidateUtf8(bool validate);
+
+private:
+	struct Record
+	{
+		size_t offset;
+		size_t length;
+		int line;
+	};
+	struct Worker // what a thread reuses from one record to the next
+	{
+		JsonParser parser;
+		std::string errInfo;
+	};
+
+	void splitRecords(std::string_view text);
+
+	std::unique_ptr<ThreadPool> m_pool;
+	std::vector<Worker> m_workers;
+	std::vector<Record> m_records;
+};
+
+}
+#endif
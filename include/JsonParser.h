@@ -1,11 +1,18 @@
 #ifndef _JSON_PARSER_H_
 #define _JSON_PARSER_H_
 
+#include <vector>
+#include <string_view>
+#include <memory_resource>
+#include <stdint.h>
 #include "JsonValue.h"
 
 namespace MyJson
 {
 
+class JsonDocument;
+class JsonPointerBatch;
+
 enum ParseResult
 {
 	eOk = 0,
@@ -21,7 +28,10 @@ enum ParseResult
 	eArrayMissCommaOrSquareBracket,	// 无效数组，缺失逗号或者方括号
 	eObjectMissKey,					// object缺失key
 	eObjectMissColon,				// object缺失冒号
-	eObjectMissCommaOrCurlyBracket	// object缺失逗号或大括号
+	eObjectMissCommaOrCurlyBracket,	// object缺失逗号或大括号
+	eNestingTooDeep,				// array与object嵌套层数超过上限
+	eFileError,						// 文件无法打开或读取
+	eInvalidUtf8					// 字符串不是有效的UTF-8
 };
 
 enum LFStyle
@@ -32,36 +42,358 @@ enum LFStyle
 	eCRLFAll	// \r\n or seperate \r and \n to chagne line, by default when parsing.
 };
 
+enum ParseEngine
+{
+	eRecursiveEngine = 0,	// recursive descent over the text, by default.
+	eStructuralIndexEngine,	// index all structural characters in one SIMD pass first, then build value from the index.
+	eIterativeEngine		// descent with an explicit stack on the heap instead of recursion, for deeply nested input.
+};
+
 class JsonParser
 {
 public:
 	JsonParser();
 	~JsonParser();
 
-	int parseJson(JsonValue& value, const std::string& json);
-	int parseJson(JsonValue& value, const std::string& json, std::string & errLoc);
+	// the text ends at the end of the view, no '\0' is needed after it and a '\0' inside it is an error
+	int parseJson(JsonValue& value, std::string_view json);
+	int parseJson(JsonValue& value, std::string_view json, std::string & errLoc);
+	int parseJson(JsonValue& value, const char* json, size_t len);
+	int parseJson(JsonValue& value, const char* json, size_t len, std::string& errLoc);
+	// unescapes strings in place inside [buf, buf + len), the values refer to buf
+	int parseJsonInSitu(JsonValue& value, char* buf, size_t len);
+	int parseJson(JsonDocument& doc, std::string_view json);
+	int parseJson(JsonDocument& doc, std::string_view json, std::string& errLoc);
+	// the file is mapped (mmap, or MapViewOfFile on Windows) instead of read into a string,
+	// strings are always copied since the mapping goes away
+	int parseFile(JsonValue& value, const char* path);
+	int parseFile(JsonValue& value, const char* path, std::string& errLoc);
+	// the result and error position of parseJson without building a value
+	int validate(std::string_view json);
+	int validate(std::string_view json, std::string& errLoc);
+	// events instead of a value, see the event handler below
+	template<typename Handler> int parseEvents(Handler& handler, std::string_view json);
+	template<typename Handler> int parseEvents(Handler& handler, std::string_view json, std::string& errLoc);
 	int errorLine();
 	int errorColumn();
 	void setParseLFStyle(LFStyle style);
+	void setParseEngine(ParseEngine engine);
+	void setBorrowStrings(bool borrow);
+	void setMaxDepth(size_t depth);
+	void setProjection(const JsonPointerBatch* paths); // build only the values of paths, NULL to build everything
+	void setValidateUtf8(bool validate); // strings must be valid UTF-8, true by default
+	void setReuseValues(bool reuse); // parse into the strings, arrays and objects the value already has, false by default
+
+	static constexpr size_t kDefaultMaxDepth = 1000;
 
 	static void encodeUtf8(unsigned int u, std::string& parseStr);
 
 private:
+	friend class JsonPushParser; // resumes the steps of the event parser between chunks
+	friend class JsonArrayParser; // splits the root array and parses its elements on threads
+	friend class JsonLazyDocument; // reads the values it is asked for and skips the rest
+
+	struct StringOutput;
+	struct InSituOutput;
+	struct CheckOutput;
+	struct Frame // an open array or object of the event parser
+	{
+		size_t count;	// elements or members so far
+		bool object;
+	};
+	class DomHandler;
+
+	void beginInput(const char* json, size_t len);
+	int parseRoot(JsonValue& value, const char* json, size_t len);
+	void skipUnexpected();
+	void locateError(int result);
+	void resetInput();
+	void makeErrorInfo(int result, std::string& errInfo);
+	std::pmr::memory_resource* containerResource()
+	{
+		return m_pArena ? m_pArena : std::pmr::get_default_resource();
+	}
+	char peek() const // the current character, '\0' at the end of the text
+	{
+		return m_pJson < m_pJsonEnd ? *m_pJson : '\0';
+	}
 	void parseWhiteSpace();
+	int scanLiteral(const char* literal);
 	int parseLiteral(JsonValue& value, const char* literal, ValueType vType);
 	int parseNumber(JsonValue& value);
-	bool parseHex4(const char* p, unsigned int & u);
+	bool parseHex4(const char* p, const char* end, unsigned int & u);
+	bool isUtf8(const char* p, const char* end) const;
 	int parseString(JsonValue& value);
+	template<typename Output> int parseStringContent(Output& out);
+	template<typename Output> static void writeUtf8(unsigned int u, Output& out);
 	int parseArray(JsonValue& value);
 	int parseObject(JsonValue& value);
+	int parseMemberKey();
+	void popArray(JsonValue& value, size_t base);
+	void popObject(JsonValue& value, size_t base);
 	int parseValue(JsonValue& value);
 
+	// structural index engine
+	bool buildStructuralIndex(const char* json, size_t len);
+	int parseIndexedRoot(JsonValue& value);
+	char structuralChar(size_t i);
+	int parseIndexedScalarEnd();
+	int parseIndexedArray(JsonValue& value);
+	int parseIndexedObject(JsonValue& value);
+	int parseIndexedValue(JsonValue& value);
+
+	// top level array split
+	bool splitArray(const char* json, size_t len, std::vector<size_t>& separators);
+	int parseElement(JsonValue& value, const char* json, size_t len, size_t begin, size_t end);
+
+	// on-demand navigation
+	int skipValue();
+
+	// path projection
+	int parseProjected(JsonValue& value, uint32_t node);
+	int parseProjectedArray(JsonValue& value, uint32_t node);
+	int parseProjectedObject(JsonValue& value, uint32_t node);
+
+	// value reuse
+	void recycle(JsonValue& value);
+	void recycleNodes(JsonValue& value);
+	void discardPartial(JsonValue& value);
+	std::string& newString(JsonValue& value);
+	void newContainer(JsonValue& value, ValueType t);
+
+	// validation
+	int checkScalar();
+	int checkKey();
+	int checkValue();
+
+	// event parser, the iterative engine builds a value from its events
+	template<typename Handler> int parseRootEvents(Handler& handler);
+	template<typename Handler> int parseValueEvents(Handler& handler);
+	template<typename Handler> int parseScalarEvent(Handler& handler);
+	template<typename Handler> int parseKeyEvent(Handler& handler);
+	int scanString(std::string_view& str);
+	void storeString(JsonValue& value, std::string_view str);
+	int parseIterative(JsonValue& value);
+
 	const char* m_pJson;
 	const char* m_pCurLineHead;
 	int m_curLine;
 	int m_curColumn;
 	LFStyle m_CRLFStyle;
+	ParseEngine m_engine;
+	const char* m_pJsonBegin;
+	const char* m_pJsonEnd;
+	char* m_pInSitu; // the mutable buffer of parseJsonInSitu, NULL otherwise
+	bool m_bBorrowStrings;
+	bool m_bValidateUtf8;
+	bool m_bPastEnd; // the error is one past the end of the text, see skipUnexpected
+	bool m_bCountLines; // lines are counted in the white space as it is parsed, instead of only when a parse fails
+	size_t m_maxDepth;
+	size_t m_depth; // arrays and objects open in the recursive and index engines
+	std::pmr::memory_resource* m_pArena; // the arena of the document being parsed, NULL otherwise
+	std::string m_stringBuffer; // strings with escapes are decoded here before they are copied to their value, reused between parses
+	std::vector<JsonValue> m_stack; // parsed children of the open arrays and objects, reused between parses
+	std::vector<Frame> m_frames; // open arrays and objects of the event parser, reused between parses
+	std::vector<uint32_t> m_structurals; // offsets of structural characters, reused between parses
+	size_t m_structuralCount;
+	size_t m_curStructural;
+	const JsonPointerBatch* m_pProjection; // the paths of setProjection, NULL to build everything
+	bool m_bReuseValues;
+	// emptied storage of the values parsed into before, with its capacity, the next one to take is at the back
+	std::vector<JsonValue> m_spareStrings;
+	std::vector<JsonValue> m_spareArrays;
+	std::vector<JsonValue> m_spareObjects;
 };
 
+// event parser
+/*
+parseEvents按文本顺序调用handler，不构建value。Handler需要提供：
+	void null();
+	void boolean(bool b);
+	void number(double d);
+	void int64(int64_t i);
+	void uint64(uint64_t u);
+	void string(std::string_view str);
+	void startObject();
+	void key(std::string_view key);
+	void endObject(size_t memberCount);
+	void startArray();
+	void endArray(size_t elementCount);
+string与key的view只在回调期间有效。
+handler作为模板参数，回调可以内联。
+与eIterativeEngine相同，使用堆上的显式栈，受setMaxDepth限制。
+语法与错误位置都与parseJson相同。
+出错时已经发出的事件不会撤销。
+*/
+template<typename Handler>
+int JsonParser::parseEvents(Handler& handler, std::string_view json)
+{
+	beginInput(json.data(), json.size());
+	int ret = parseRootEvents(handler);
+	locateError(ret);
+	resetInput();
+	return ret;
+}
+
+template<typename Handler>
+int JsonParser::parseEvents(Handler& handler, std::string_view json, std::string& errInfo)
+{
+	beginInput(json.data(), json.size());
+	int ret = parseRootEvents(handler);
+	locateError(ret);
+	makeErrorInfo(ret, errInfo);
+	resetInput();
+	return ret;
+}
+
+template<typename Handler>
+int JsonParser::parseRootEvents(Handler& handler)
+{
+	parseWhiteSpace();
+	int ret = parseValueEvents(handler);
+	if (ret == eOk)
+	{
+		parseWhiteSpace();
+		if (m_pJson != m_pJsonEnd)
+			ret = eRootNotSingular;
+	}
+	return ret;
+}
+
+// one value from m_pJson, open arrays and objects wait on m_frames
+template<typename Handler>
+int JsonParser::parseValueEvents(Handler& handler)
+{
+	m_frames.clear();
+	int ret = eOk;
+	while (true)
+	{
+		// a value starts at m_pJson
+		char ch = peek();
+		if (ch == '[' || ch == '{')
+		{
+			if (m_frames.size() == m_maxDepth)
+				return eNestingTooDeep;
+			bool object = ch == '{';
+			m_pJson++;
+			object ? handler.startObject() : handler.startArray();
+			parseWhiteSpace();
+			if (peek() != (object ? '}' : ']'))
+			{
+				m_frames.push_back({ 0, object });
+				if (object)
+				{
+					ret = parseKeyEvent(handler);
+					if (ret != eOk)
+						return ret;
+				}
+				else
+				{
+					parseWhiteSpace();
+				}
+				continue;
+			}
+			m_pJson++; // empty, complete at once
+			object ? handler.endObject(0) : handler.endArray(0);
+		}
+		else
+		{
+			ret = parseScalarEvent(handler);
+			if (ret != eOk)
+				return ret;
+		}
+
+		// the value belongs to the innermost open array or object, close them as far as they end
+		while (!m_frames.empty())
+		{
+			Frame& frame = m_frames.back();
+			frame.count++;
+			parseWhiteSpace();
+			char ch = peek();
+			if (ch == ',')
+			{
+				m_pJson++;
+				if (frame.object)
+				{
+					ret = parseKeyEvent(handler);
+					if (ret != eOk)
+						return ret;
+				}
+				else
+				{
+					parseWhiteSpace();
+				}
+				break;
+			}
+			else if (ch == (frame.object ? '}' : ']'))
+			{
+				m_pJson++;
+				size_t count = frame.count;
+				bool object = frame.object;
+				m_frames.pop_back();
+				object ? handler.endObject(count) : handler.endArray(count);
+			}
+			else if (frame.object)
+			{
+				return eObjectMissCommaOrCurlyBracket;
+			}
+			else
+			{
+				skipUnexpected();
+				return eArrayMissCommaOrSquareBracket;
+			}
+		}
+		if (m_frames.empty())
+			return eOk;
+	}
+}
+
+template<typename Handler>
+int JsonParser::parseScalarEvent(Handler& handler)
+{
+	if (peek() == '\"')
+	{
+		std::string_view str;
+		int ret = scanString(str);
+		if (ret == eOk)
+			handler.string(str);
+		return ret;
+	}
+	JsonValue scalar; // null, boolean or number, never allocates
+	int ret = parseValue(scalar);
+	if (ret != eOk)
+		return ret;
+	switch (scalar.type())
+	{
+	case eNull:		handler.null(); break;
+	case eTrue:		handler.boolean(true); break;
+	case eFalse:	handler.boolean(false); break;
+	case eInt64:	handler.int64(scalar.getInt64()); break;
+	case eUint64:	handler.uint64(scalar.getUint64()); break;
+	default:		handler.number(scalar.getNumber()); break;
+	}
+	return eOk;
+}
+
+// key of a member up to the start of its value
+template<typename Handler>
+int JsonParser::parseKeyEvent(Handler& handler)
+{
+	parseWhiteSpace();
+	if (peek() != '\"')
+		return eObjectMissKey;
+	std::string_view key;
+	int ret = scanString(key);
+	if (ret != eOk)
+		return ret;
+	handler.key(key);
+	parseWhiteSpace();
+	if (peek() != ':')
+		return eObjectMissColon;
+	m_pJson++;
+	parseWhiteSpace();
+	return eOk;
+}
+
 }
 #endif
@@ -0,0 +1,95 @@
+#ifndef _JSON_POINTER_H_
+#define _JSON_POINTER_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+#include "JsonValue.h"
+
+namespace MyJson
+{
+
+class JsonDocument;
+
+// a JSON Pointer (RFC 6901) like "/a/b/0/c", parsed once and used for any number of lookups.
+// the reference tokens are unescaped ("~1" -> '/', "~0" -> '~') with their key hashes and array indices computed in advance,
+// a lookup compares the keys in place and does not build a std::string.
+class JsonPointer
+{
+public:
+	JsonPointer(); // "", the whole value
+	explicit JsonPointer(std::string_view pointer);
+
+	bool isValid() const; // false if the text is not a JSON Pointer, nothing is then resolved
+	size_t size() const; // count of reference tokens
+	std::string_view token(size_t i) const; // unescaped
+
+	// nullptr if the value is not there
+	const JsonValue* resolve(const JsonValue& root) const;
+	JsonValue* resolve(JsonValue& root) const;
+	// creates the missing members, a null becomes an array if the token is an index or "-", an object otherwise.
+	// the index equal to the size of an array or "-" appends a null, a created container takes the resource of the one it is in.
+	// nullptr if the pointer is not valid, or a scalar, an index past the end or a token that is not an index of an array is on the way.
+	JsonValue* resolveOrCreate(JsonValue& root) const;
+	// the same in the tree of doc: a null root becomes a container of its arena, and the keys added to the
+	// objects of the arena are kept there too, so a tree that is arena only stays so.
+	JsonValue* resolveOrCreate(JsonDocument& doc) const;
+
+private:
+	friend class JsonPointerBatch;
+	friend class JsonParser; // reads the tokens of a projection
+
+	static constexpr size_t kNoIndex = SIZE_MAX;
+	struct Token
+	{
+		std::string key;
+		size_t hash;	// std::hash<std::string_view> of key, the hash of the object index
+		size_t index;	// kNoIndex if key is not an array index
+	};
+
+	static Token makeToken(std::string key);
+	static const JsonValue* step(const JsonValue& value, const Token& token);
+	JsonValue* create(JsonValue& root, std::pmr::memory_resource* resource, std::pmr::memory_resource* arena) const;
+	static JsonValue* stepOrCreate(JsonValue& value, const Token& token, std::pmr::memory_resource*& resource,
+		std::pmr::memory_resource* arena);
+
+	std::vector<Token> m_tokens;
+	bool m_bValid;
+};
+
+// resolves many pointers against one value in a single traversal:
+// the pointers are merged into a tree of their tokens, a prefix they share is looked up once.
+class JsonPointerBatch
+{
+public:
+	JsonPointerBatch();
+
+	size_t add(const JsonPointer& pointer); // position of its result
+	size_t add(std::string_view pointer);
+	size_t size() const;
+	void clear();
+
+	// results[i] is the value of the i-th pointer added, nullptr if it is not there or the pointer is not valid
+	void resolve(const JsonValue& root, std::vector<const JsonValue*>& results) const;
+
+private:
+	friend class JsonParser; // builds only the subtrees of the pointers, see JsonParser::setProjection
+
+	static constexpr uint32_t kNone = UINT32_MAX;
+	struct Node
+	{
+		JsonPointer::Token token; // empty for the root
+		uint32_t firstChild;
+		uint32_t nextSibling;
+		uint32_t firstPointer; // pointers that end here, linked by m_nextPointer
+	};
+
+	void visit(uint32_t node, const JsonValue* value, std::vector<const JsonValue*>& results) const;
+
+	std::vector<Node> m_nodes; // m_nodes[0] is the root
+	std::vector<uint32_t> m_nextPointer;
+};
+
+}
+#endif
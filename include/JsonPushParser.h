@@ -0,0 +1,59 @@
+#ifndef _JSON_PUSH_PARSER_H_
+#define _JSON_PUSH_PARSER_H_
+
+#include <string>
+#include "JsonParser.h"
+
+namespace MyJson
+{
+
+// parses a text that arrives in chunks, e.g. from a socket: the value is built while the chunks are fed.
+// the result, the value and the error position are the same as parsing the whole text with JsonParser.
+// only the characters of a string, number or literal that is cut by the end of a chunk are kept until the next chunk.
+class JsonPushParser
+{
+public:
+	JsonPushParser();
+	~JsonPushParser();
+
+	int feed(const char* data, size_t len); // eOk while the text so far can still be valid, the error otherwise
+	int finish(JsonValue& value); // the end of the text, ready for the next text after it
+	void reset(); // drop the text fed so far
+	int errorLine();
+	int errorColumn();
+	void setParseLFStyle(LFStyle style);
+	void setMaxDepth(size_t depth);
+	void setValidateUtf8(bool validate);
+
+private:
+	enum State
+	{
+		eStateValue,		// white space, then a value
+		eStateArrayFirst,	// white space, then the first element or ']'
+		eStateObjectFirst,	// white space, then the first key or '}'
+		eStateKey,			// white space, then a key
+		eStateColon,		// white space, then ':'
+		eStateAfterValue,	// white space, then ',' or the end of the innermost array or object
+		eStateEnd,			// white space after the root
+		eStateDone
+	};
+
+	int parse();
+	bool tokenComplete();
+	void closeContainer();
+	void completeValue();
+
+	JsonParser m_parser;	// its m_stack and m_frames keep the values and the open arrays and objects between chunks
+	std::string m_buffer;	// the text not parsed yet
+	size_t m_offset;		// offset of m_buffer in the whole text
+	size_t m_scanned;		// offset in the whole text up to which the pending string or number has no end yet
+	size_t m_lineHead;		// offset in the whole text of the current line head
+	State m_state;
+	int m_result;
+	bool m_bFinishing;
+	int m_errorLine;
+	int m_errorColumn;
+};
+
+}
+#endif
@@ -2,9 +2,10 @@
 #define _JSON_VALUE_H_
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
-#include <variant>
+#include <memory_resource>
+#include <stdint.h>
 
 namespace MyJson
 {
@@ -17,7 +18,9 @@ enum ValueType
 	eNumber,
 	eString,
 	eArray,
-	eObject
+	eObject,
+	eInt64,		// integer number in int64 range
+	eUint64		// integer number above int64 range
 };
 
 class JsonValue
@@ -25,9 +28,12 @@ class JsonValue
 public:
 	JsonValue();
 	JsonValue(ValueType t);
+	JsonValue(ValueType t, std::pmr::memory_resource* resource); // arrays and objects allocate from resource
 	JsonValue(bool b);
 	JsonValue(double val);
 	JsonValue(int val);
+	JsonValue(int64_t val);
+	JsonValue(uint64_t val);
 	JsonValue(const std::string& str);
 	JsonValue(const char* str);
 	JsonValue(const char* begin, const char* end);
@@ -35,24 +41,25 @@ public:
 	JsonValue(std::nullptr_t p) = delete;
 	JsonValue(void* p) = delete;
 	JsonValue(const JsonValue& value);
-	JsonValue(JsonValue&& value);
+	JsonValue(JsonValue&& value) noexcept;
 
 	~JsonValue();
 
 	JsonValue& operator=(const JsonValue& value);
-	JsonValue& operator=(JsonValue&& value);
+	JsonValue& operator=(JsonValue&& value) noexcept;
 
 	bool operator==(const JsonValue& value) const;
 	bool operator!=(const JsonValue& value) const;
 
 private:
 	void copyFrom(const JsonValue& value);
-	void moveFrom(JsonValue& value);
+	void moveFrom(JsonValue& value) noexcept;
 
 public:
 	static const JsonValue sNullValue;
 
 	void setType(ValueType t);
+	void setType(ValueType t, std::pmr::memory_resource* resource);
 	ValueType type() const;
 
 	// null
@@ -66,17 +73,27 @@ public:
 	void setBool(bool b);
 	bool getBool() const;
 
-	// number
+	// number: eNumber, eInt64 or eUint64
 	bool isNumber() const;
 	double getNumber() const;
 	void setNumber(double val);
-
-	// string
+	bool isInt64() const;
+	bool isUint64() const;
+	int64_t getInt64() const;
+	uint64_t getUint64() const;
+	void setInt64(int64_t val);
+	void setUint64(uint64_t val);
+
+	// string: owned, or borrowed from a buffer that must outlive the value (see setStringView)
 	bool isString() const;
-	const std::string& getString() const;
+	std::string getString() const; // a copy, owned or borrowed, getStringView reads without copying
+	std::string_view getStringView() const;
+	bool isBorrowedString() const;
+	void setStringView(std::string_view str);
 	void setString(const char* str, size_t len);
 	void setString(const char* begin, const char* end);
 	void setString(const std::string& str);
+	void setString(std::string&& str);
 
 	// array
 	bool isArray() const;
@@ -93,25 +110,92 @@ public:
 
 	// object
 	bool isObject() const;
-	bool containsKey(const std::string& key) const;
+	bool containsKey(std::string_view key) const;
 	std::vector<std::string> getKeys() const;
-	const JsonValue& get(const std::string& key) const;
+	std::vector<std::string_view> getKeyViews() const;
+	const JsonValue& get(std::string_view key) const;
 	void appendKey(const std::string& key, const JsonValue& value);
+	void appendKey(const std::string& key, JsonValue&& value);
+	void appendKeyView(std::string_view key, JsonValue&& value);
+	void appendMember(JsonValue&& key, JsonValue&& value);
 	bool removeKey(const std::string& key, JsonValue& removed);
 	bool removeKey(const std::string& key);
 	JsonValue& operator[](const std::string& key);
+	const JsonValue& operator[](const std::string& key) const;
 
 	// array & object in common
 	size_t size() const;
 	void clear();
 	bool empty() const;
+	void reserve(size_t newCapacity);
 
 private:
+	friend class JsonPointer; // looks keys up with the hashes it computed in advance
+	friend class JsonParser; // parses into the storage of the value parsed before, see JsonParser::setReuseValues
+	friend class JsonDocument; // forgets a tree that lives in its arena without destroying the nodes
+
 	using StringType = std::string;
-	using ArrayType = std::vector<JsonValue>;
-	using ObjectType = std::map<std::string, JsonValue>;
-	ValueType m_valueType;
-	std::variant<double, std::string, std::vector<JsonValue>, std::map<std::string, JsonValue>> m_var;
+	using ArrayType = std::pmr::vector<JsonValue>;
+	struct Member;
+	// members in insertion order, small objects are scanned, large ones keep a hash index
+	class ObjectType
+	{
+	public:
+		explicit ObjectType(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+		ObjectType(const ObjectType& other, std::pmr::memory_resource* resource);
+		std::pmr::memory_resource* resource() const;
+		size_t size() const;
+		bool empty() const;
+		void clear();
+		void reserve(size_t newCapacity);
+		const Member* begin() const;
+		const Member* end() const;
+		Member* begin();
+		Member* end();
+		Member* find(std::string_view key);
+		const Member* find(std::string_view key) const;
+		Member* find(std::string_view key, size_t hash); // hash: std::hash<std::string_view> of key
+		const Member* find(std::string_view key, size_t hash) const;
+		JsonValue& add(JsonValue&& key, JsonValue&& value); // key must not be in the object yet
+		void erase(Member* member);
+	private:
+		const Member* scan(std::string_view key) const;
+		const Member* lookup(std::string_view key, size_t hash) const;
+		void buildIndex();
+		void indexMember(uint32_t position);
+		std::pmr::vector<Member> m_members;
+		// open addressing slots of member position + 1, 0 for an empty slot.
+		// kept up to date by every change once there are more than kObjectScanLimit members, empty before.
+		std::pmr::vector<uint32_t> m_index;
+	};
+
+	// a scalar in place, or a pointer to the out-of-line string, array or object
+	union Payload
+	{
+		double number;
+		int64_t int64;
+		uint64_t uint64;
+		const char* view;		// borrowed string, the length is in m_meta
+		StringType* string;		// owned string
+		ArrayType* array;
+		ObjectType* object;
+	};
+	// m_meta: ValueType in bits 0 ~ 3, kBorrowed in bit 4, length of a borrowed string from bit 8
+	static constexpr uint64_t kTypeMask = 0x0F;
+	static constexpr uint64_t kBorrowed = 0x10;
+	static constexpr int kLengthShift = 8;
+
+	void release();
+	void init(ValueType t, std::pmr::memory_resource* resource);
+
+	Payload m_payload;
+	uint64_t m_meta;
+};
+
+struct JsonValue::Member
+{
+	JsonValue key; // always a string
+	JsonValue value;
 };
 
 }
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <atomic>
+#include "JsonArrayParser.h"
+#include "JsonThreadPool.h"
+
+namespace MyJson
+{
+
+JsonArrayParser::JsonArrayParser(unsigned int threadCount /*= 0*/) :
+	m_pool(std::make_unique<ThreadPool>(threadCount)),
+	m_parsers(m_pool->size()) {}
+
+JsonArrayParser::~JsonArrayParser() {}
+
+int JsonArrayParser::parseJson(JsonValue& value, std::string_view json)
+{
+	return parseJson(value, json, m_errInfo);
+}
+
+int JsonArrayParser::parseJson(JsonValue& value, std::string_view json, std::string& errInfo)
+{
+	JsonParser& parser = m_parsers[0];
+	if (json.size() >= kMinParallelSize && parseElements(value, json) == eOk)
+	{
+		parser.makeErrorInfo(eOk, errInfo);
+		return eOk;
+	}
+	// the serial parse gives the first error and its position
+	return parser.parseJson(value, json, errInfo);
+}
+
+// eOk if the root is an array and all its elements are parsed, the error is not reported otherwise
+int JsonArrayParser::parseElements(JsonValue& value, std::string_view json)
+{
+	value.setNull();
+	if (!m_parsers[0].splitArray(json.data(), json.size(), m_separators) || m_separators.size() < 3)
+		return eInvalidValue; // not an array of two or more elements
+	size_t count = m_separators.size() - 1;
+	value.setType(eArray);
+	value.resize(count);
+
+	// threads take blocks of elements in turn and stop at the first failure
+	const size_t kBlockSize = 16;
+	std::atomic<size_t> nextBlock(0);
+	std::atomic<bool> failed(false);
+	m_pool->run([&](unsigned int index) {
+		JsonParser& parser = m_parsers[index];
+		while (!failed.load(std::memory_order_relaxed))
+		{
+			size_t first = nextBlock.fetch_add(kBlockSize);
+			if (first >= count)
+				break;
+			size_t last = std::min(first + kBlockSize, count);
+			for (size_t i = first; i < last; i++)
+			{
+				if (parser.parseElement(value[i], json.data(), json.size(), m_separators[i] + 1, m_separators[i + 1]) != eOk)
+				{
+					failed = true;
+					break;
+				}
+			}
+		}
+	});
+	if (failed)
+	{
+		value.setNull();
+		return eInvalidValue;
+	}
+	return eOk;
+}
+
+int JsonArrayParser::errorLine()
+{
+	return m_parsers[0].errorLine();
+}
+
+int JsonArrayParser::errorColumn()
+{
+	return m_parsers[0].errorColumn();
+}
+
+unsigned int JsonArrayParser::threadCount() const
+{
+	return m_pool->size();
+}
+
+void JsonArrayParser::setParseLFStyle(LFStyle style)
+{
+	for (JsonParser& parser : m_parsers)
+		parser.setParseLFStyle(style);
+}
+
+void JsonArrayParser::setMaxDepth(size_t depth)
+{
+	for (JsonParser& parser : m_parsers)
+		parser.setMaxDepth(depth);
+}
+
+void JsonArrayParser::setValidateUtf8(bool validate)
+{
+	for (JsonParser& parser : m_parsers)
+		parser.setValidateUtf8(validate);
+}
+
+}
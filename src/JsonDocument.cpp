@@ -0,0 +1,47 @@
+#include "JsonDocument.h"
+
+namespace MyJson
+{
+
+JsonDocument::JsonDocument() :
+	m_arena(),
+	m_root(),
+	m_bArenaOnly(true) {}
+
+JsonDocument::JsonDocument(size_t initialSize, std::pmr::memory_resource* upstream /*= std::pmr::get_default_resource()*/) :
+	m_arena(initialSize, upstream),
+	m_root(),
+	m_bArenaOnly(true) {}
+
+JsonDocument::~JsonDocument()
+{
+	clear();
+}
+
+const JsonValue& JsonDocument::root() const
+{
+	return m_root;
+}
+
+JsonValue& JsonDocument::mutableRoot() // the caller may add storage outside the arena
+{
+	m_bArenaOnly = false;
+	return m_root;
+}
+
+std::pmr::memory_resource* JsonDocument::resource() // use it to add arrays and objects to the tree
+{
+	return &m_arena;
+}
+
+void JsonDocument::clear() // drop the tree, then give all the memory back at once
+{
+	if (m_bArenaOnly) // every node and string is in the arena, nothing to destroy one by one
+		m_root.m_meta = eNull;
+	else
+		m_root.setNull();
+	m_arena.release();
+	m_bArenaOnly = true;
+}
+
+}
@@ -0,0 +1,123 @@
+#include "JsonFile.h"
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <stdint.h>
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace MyJson
+{
+
+MappedFile::MappedFile() :
+	m_pData(NULL),
+	m_size(0),
+	m_bMapped(false) {}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#if !defined(_WIN32)
+bool MappedFile::open(const char* path)
+{
+	close();
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		::close(fd);
+		return false;
+	}
+	size_t size = (size_t)st.st_size;
+	if (size == 0) // mmap of 0 bytes is an error
+	{
+		::close(fd);
+		m_pData = "";
+		return true;
+	}
+	void* p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // the mapping keeps the file
+	if (p == MAP_FAILED)
+		return false;
+	madvise(p, size, MADV_SEQUENTIAL); // parsing reads it once from the start
+	m_pData = (const char*)p;
+	m_size = size;
+	m_bMapped = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_bMapped)
+		munmap((void*)m_pData, m_size);
+	m_pData = NULL;
+	m_size = 0;
+	m_bMapped = false;
+}
+#else
+bool MappedFile::open(const char* path)
+{
+	close();
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &size) || (uint64_t)size.QuadPart > SIZE_MAX)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	if (size.QuadPart == 0) // a mapping of an empty file is an error
+	{
+		CloseHandle(file);
+		m_pData = "";
+		return true;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file); // the mapping keeps the file
+	if (mapping == NULL)
+		return false;
+	void* p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping); // the view keeps the mapping
+	if (p == NULL)
+		return false;
+	m_pData = (const char*)p;
+	m_size = (size_t)size.QuadPart;
+	m_bMapped = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_bMapped)
+		UnmapViewOfFile(m_pData);
+	m_pData = NULL;
+	m_size = 0;
+	m_bMapped = false;
+}
+#endif
+
+const char* MappedFile::data() const
+{
+	return m_pData;
+}
+
+size_t MappedFile::size() const
+{
+	return m_size;
+}
+
+}
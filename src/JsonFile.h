@@ -0,0 +1,33 @@
+#ifndef _JSON_FILE_H_
+#define _JSON_FILE_H_
+
+#include <stddef.h>
+
+// internal read only file mapping of JsonParser::parseFile, not part of the public interface.
+namespace MyJson
+{
+
+// the contents of a file, mapped read only instead of read into a string (POSIX mmap, Windows MapViewOfFile).
+// the text is parsed as a view of size() bytes, so nothing follows the file in the mapping.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const char* path);
+	void close();
+	const char* data() const;
+	size_t size() const;
+
+private:
+	const char* m_pData;
+	size_t m_size;
+	bool m_bMapped; // false for an empty file, which has nothing to map
+};
+
+}
+#endif
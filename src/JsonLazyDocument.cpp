@@ -0,0 +1,358 @@
+#include "JsonLazyDocument.h"
+#include "JsonNumber.h"
+
+namespace MyJson
+{
+
+// on-demand navigation
+/*
+JsonCursor只记录value在文本中的起始位置，读取时才解析：
+	- key与标量使用JsonParser的scanString/parseValue解析，与parseJson的语法、转义与number转换完全相同
+	- 查找key时逐个比较成员的key，其余成员的value用JsonParser::skipValue按块跳过，不构建value
+	- 重复的key与JsonValue相同取最后一个，所以查找总是看完整个object
+	- 查找index时跳过它之前的元素
+只有读取与经过的文本被校验，跳过的部分中的错误不一定被发现，需要完整校验时使用parse。
+*/
+JsonCursor::JsonCursor() :
+	m_pDoc(NULL),
+	m_pValue(NULL),
+	m_result(eOk) {}
+
+JsonCursor::JsonCursor(JsonLazyDocument* pDoc, const char* pValue, int result) :
+	m_pDoc(pDoc),
+	m_pValue(pValue),
+	m_result(result) {}
+
+bool JsonCursor::exists() const
+{
+	return m_pValue != NULL;
+}
+
+int JsonCursor::result() const
+{
+	return m_result;
+}
+
+ValueType JsonCursor::type() const
+{
+	if (!m_pValue)
+		return eNull;
+	switch (*m_pValue)
+	{
+	case 'n':	return eNull;
+	case 't':	return eTrue;
+	case 'f':	return eFalse;
+	case '\"':	return eString;
+	case '[':	return eArray;
+	case '{':	return eObject;
+	default: // eNumber, eInt64 or eUint64
+		{
+			JsonValue value;
+			read(value);
+			return value.type();
+		}
+	}
+}
+
+bool JsonCursor::isNull() const
+{
+	return m_pValue && *m_pValue == 'n';
+}
+
+bool JsonCursor::isBool() const
+{
+	return m_pValue && (*m_pValue == 't' || *m_pValue == 'f');
+}
+
+bool JsonCursor::isNumber() const
+{
+	return m_pValue && (*m_pValue == '-' || Number::isDigit(*m_pValue));
+}
+
+bool JsonCursor::isString() const
+{
+	return m_pValue && *m_pValue == '\"';
+}
+
+bool JsonCursor::isArray() const
+{
+	return m_pValue && *m_pValue == '[';
+}
+
+bool JsonCursor::isObject() const
+{
+	return m_pValue && *m_pValue == '{';
+}
+
+bool JsonCursor::getBool() const
+{
+	JsonValue value;
+	return isBool() && read(value) == eOk && value.getBool();
+}
+
+double JsonCursor::getNumber() const
+{
+	JsonValue value;
+	if (!isNumber() || read(value) != eOk)
+		return 0;
+	return value.getNumber();
+}
+
+int64_t JsonCursor::getInt64() const
+{
+	JsonValue value;
+	if (!isNumber() || read(value) != eOk || !value.isInt64())
+		return 0;
+	return value.getInt64();
+}
+
+uint64_t JsonCursor::getUint64() const
+{
+	JsonValue value;
+	if (!isNumber() || read(value) != eOk || !value.isUint64())
+		return 0;
+	return value.getUint64();
+}
+
+std::string JsonCursor::getString() const
+{
+	return std::string(getStringView());
+}
+
+std::string_view JsonCursor::getStringView() const
+{
+	std::string_view str;
+	if (!isString() || readString(str) != eOk)
+		return std::string_view();
+	return str;
+}
+
+size_t JsonCursor::size() const
+{
+	return isArray() || isObject() ? m_pDoc->count(m_pValue) : 0;
+}
+
+bool JsonCursor::containsKey(std::string_view key) const
+{
+	return (*this)[key].exists();
+}
+
+JsonCursor JsonCursor::operator[](std::string_view key) const
+{
+	if (!isObject())
+		return JsonCursor(m_pDoc, NULL, m_result);
+	return m_pDoc->findMember(m_pValue, key);
+}
+
+JsonCursor JsonCursor::operator[](size_t index) const
+{
+	if (!isArray())
+		return JsonCursor(m_pDoc, NULL, m_result);
+	return m_pDoc->findElement(m_pValue, index);
+}
+
+int JsonCursor::parse(JsonValue& value) const
+{
+	value.setNull();
+	if (!m_pValue)
+		return m_result != eOk ? m_result : eExpectValue;
+	return read(value);
+}
+
+// the value at the cursor, an error is kept for result()
+int JsonCursor::read(JsonValue& value) const
+{
+	int ret = m_pDoc->readValue(m_pValue, value);
+	if (ret != eOk)
+		m_result = ret;
+	return ret;
+}
+
+int JsonCursor::readString(std::string_view& str) const
+{
+	int ret = m_pDoc->readString(m_pValue, str);
+	if (ret != eOk)
+		m_result = ret;
+	return ret;
+}
+
+JsonLazyDocument::JsonLazyDocument(std::string_view json /*= std::string_view()*/)
+{
+	reset(json);
+}
+
+JsonLazyDocument::~JsonLazyDocument() {}
+
+void JsonLazyDocument::reset(std::string_view json)
+{
+	m_json = json;
+	m_parser.beginInput(json.data(), json.size());
+}
+
+JsonCursor JsonLazyDocument::root()
+{
+	m_parser.m_pJson = m_json.data();
+	m_parser.parseWhiteSpace();
+	if (m_parser.m_pJson == m_parser.m_pJsonEnd)
+		return JsonCursor(this, NULL, eExpectValue);
+	return JsonCursor(this, m_parser.m_pJson, eOk);
+}
+
+JsonCursor JsonLazyDocument::operator[](std::string_view key)
+{
+	return root()[key];
+}
+
+JsonCursor JsonLazyDocument::operator[](size_t index)
+{
+	return root()[index];
+}
+
+void JsonLazyDocument::setMaxDepth(size_t depth)
+{
+	m_parser.setMaxDepth(depth);
+}
+
+// the value at pValue with the grammar of parseJson
+int JsonLazyDocument::readValue(const char* pValue, JsonValue& value)
+{
+	m_parser.m_pJson = pValue;
+	m_parser.m_depth = 0;
+	int ret = m_parser.parseValue(value);
+	m_parser.m_stack.clear(); // an error leaves the values parsed before it there
+	if (ret == eOk)
+		ret = readEnd();
+	if (ret != eOk)
+		value.setNull();
+	return ret;
+}
+
+// the string at pValue, str is empty if it is not valid
+int JsonLazyDocument::readString(const char* pValue, std::string_view& str)
+{
+	m_parser.m_pJson = pValue;
+	int ret = m_parser.scanString(str);
+	if (ret == eOk)
+		ret = readEnd();
+	if (ret != eOk)
+		str = std::string_view();
+	return ret;
+}
+
+// a value read ends where the text may go on, "12abc" or "truex" is not a value that is followed by something
+int JsonLazyDocument::readEnd() const
+{
+	switch (m_parser.peek())
+	{
+	case '\0':
+		return m_parser.m_pJson == m_parser.m_pJsonEnd ? eOk : eInvalidValue;
+	case ' ': case '\t': case '\n': case '\r': case ',': case ']': case '}':
+		return eOk;
+	default:
+		return eInvalidValue;
+	}
+}
+
+JsonCursor JsonLazyDocument::findMember(const char* pObject, std::string_view key)
+{
+	JsonParser& parser = m_parser;
+	parser.m_pJson = pObject + 1;
+	parser.parseWhiteSpace();
+	if (parser.peek() == '}')
+		return JsonCursor(this, NULL, eOk);
+	const char* pFound = NULL;
+	while (true)
+	{
+		parser.parseWhiteSpace();
+		if (parser.peek() != '\"')
+			return JsonCursor(this, NULL, eObjectMissKey);
+		std::string_view name;
+		int ret = parser.scanString(name);
+		if (ret != eOk)
+			return JsonCursor(this, NULL, ret);
+		bool match = name == key;
+		parser.parseWhiteSpace();
+		if (parser.peek() != ':')
+			return JsonCursor(this, NULL, eObjectMissColon);
+		parser.m_pJson++;
+		parser.parseWhiteSpace();
+		if (match)
+			pFound = parser.m_pJson;
+		ret = parser.skipValue();
+		if (ret != eOk)
+			return JsonCursor(this, NULL, ret);
+		parser.parseWhiteSpace();
+		char ch = parser.peek();
+		if (ch == '}')
+			return JsonCursor(this, pFound, eOk);
+		if (ch != ',')
+			return JsonCursor(this, NULL, eObjectMissCommaOrCurlyBracket);
+		parser.m_pJson++;
+	}
+}
+
+JsonCursor JsonLazyDocument::findElement(const char* pArray, size_t index)
+{
+	JsonParser& parser = m_parser;
+	parser.m_pJson = pArray + 1;
+	parser.parseWhiteSpace();
+	if (parser.peek() == ']')
+		return JsonCursor(this, NULL, eOk);
+	for (size_t i = 0; ; i++)
+	{
+		parser.parseWhiteSpace();
+		if (i == index) // a value starts here, the rest of it is checked when it is read
+		{
+			char ch = parser.peek();
+			if (ch == '\0' || ch == ',' || ch == ':' || ch == ']' || ch == '}')
+				return JsonCursor(this, NULL, parser.m_pJson == parser.m_pJsonEnd ? eExpectValue : eInvalidValue);
+			return JsonCursor(this, parser.m_pJson, eOk);
+		}
+		int ret = parser.skipValue();
+		if (ret != eOk)
+			return JsonCursor(this, NULL, ret);
+		parser.parseWhiteSpace();
+		char ch = parser.peek();
+		if (ch == ']')
+			return JsonCursor(this, NULL, eOk);
+		if (ch != ',')
+			return JsonCursor(this, NULL, eArrayMissCommaOrSquareBracket);
+		parser.m_pJson++;
+	}
+}
+
+// elements of an array or members of an object up to its end or the first error
+size_t JsonLazyDocument::count(const char* pContainer)
+{
+	JsonParser& parser = m_parser;
+	bool object = *pContainer == '{';
+	parser.m_pJson = pContainer + 1;
+	parser.parseWhiteSpace();
+	if (parser.peek() == (object ? '}' : ']'))
+		return 0;
+	size_t n = 0;
+	while (true)
+	{
+		parser.parseWhiteSpace();
+		if (object)
+		{
+			if (parser.peek() != '\"' || parser.skipValue() != eOk)
+				return n;
+			parser.parseWhiteSpace();
+			if (parser.peek() != ':')
+				return n;
+			parser.m_pJson++;
+			parser.parseWhiteSpace();
+		}
+		if (parser.skipValue() != eOk)
+			return n;
+		n++;
+		parser.parseWhiteSpace();
+		char ch = parser.peek();
+		if (ch != ',')
+			return n;
+		parser.m_pJson++;
+	}
+}
+
+}
@@ -0,0 +1,95 @@
+#include <atomic>
+#include <string.h>
+#include "JsonLinesParser.h"
+#include "JsonThreadPool.h"
+
+namespace MyJson
+{
+
+JsonLinesParser::JsonLinesParser(unsigned int threadCount /*= 0*/) :
+	m_pool(std::make_unique<ThreadPool>(threadCount)),
+	m_workers(m_pool->size()) {}
+
+JsonLinesParser::~JsonLinesParser() {}
+
+unsigned int JsonLinesParser::threadCount() const
+{
+	return m_pool->size();
+}
+
+void JsonLinesParser::setParseEngine(ParseEngine engine)
+{
+	for (Worker& worker : m_workers)
+		worker.parser.setParseEngine(engine);
+}
+
+void JsonLinesParser::setMaxDepth(size_t depth)
+{
+	for (Worker& worker : m_workers)
+		worker.parser.setMaxDepth(depth);
+}
+
+void JsonLinesParser::setValidateUtf8(bool validate)
+{
+	for (Worker& worker : m_workers)
+		worker.parser.setValidateUtf8(validate);
+}
+
+// lines end with "\n" or "\r\n", a line of white space only is not a record.
+// a JSON text never has a raw '\n' inside a string, so splitting does not look into the records.
+void JsonLinesParser::splitRecords(std::string_view text)
+{
+	m_records.clear();
+	const char* p = text.data();
+	const char* end = text.data() + text.size();
+	for (int line = 1; p < end; line++)
+	{
+		const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+		if (lineEnd == NULL)
+			lineEnd = end;
+		const char* last = lineEnd;
+		while (last > p && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r'))
+			last--;
+		const char* first = p;
+		while (first < last && (*first == ' ' || *first == '\t'))
+			first++;
+		if (first < last)
+			m_records.push_back({ size_t(p - text.data()), size_t(last - p), line });
+		p = lineEnd + 1;
+	}
+}
+
+size_t JsonLinesParser::parse(std::string_view text, std::vector<JsonValue>& values, std::vector<JsonLineResult>& results)
+{
+	splitRecords(text);
+	values.clear();
+	values.resize(m_records.size());
+	results.resize(m_records.size());
+
+	// threads take blocks of records in turn, so long and short records even out
+	const size_t kBlockSize = 64;
+	std::atomic<size_t> nextBlock(0);
+	std::atomic<size_t> failed(0);
+	m_pool->run([&](unsigned int index) {
+		Worker& worker = m_workers[index];
+		size_t localFailed = 0;
+		while (true)
+		{
+			size_t first = nextBlock.fetch_add(kBlockSize);
+			if (first >= m_records.size())
+				break;
+			size_t last = std::min(first + kBlockSize, m_records.size());
+			for (size_t i = first; i < last; i++)
+			{
+				const Record& record = m_records[i];
+				int ret = worker.parser.parseJson(values[i], text.substr(record.offset, record.length), worker.errInfo);
+				results[i] = { ret, record.line, worker.parser.errorColumn() };
+				localFailed += ret != eOk;
+			}
+		}
+		failed += localFailed;
+	});
+	return failed;
+}
+
+}
@@ -0,0 +1,47 @@
+#ifndef _JSON_NUMBER_H_
+#define _JSON_NUMBER_H_
+
+#include <stdint.h>
+
+// internal number scanning and conversion, not part of the public interface.
+namespace MyJson
+{
+namespace Number
+{
+
+// locale independent, unlike isdigit
+inline bool isDigit(char ch)
+{
+	return (unsigned char)(ch - '0') < 10;
+}
+
+// a number validated and decomposed in one pass: value = (-1)^negative * mantissa * 10^exponent
+struct Decimal
+{
+	const char* begin;	// first character of the number
+	const char* end;	// one past the last character of the number
+	bool negative;
+	bool integer;		// no fraction and no exponent
+	bool truncated;		// more than 19 significant digits, mantissa holds the first 19 of them
+	uint64_t mantissa;
+	int64_t exponent;
+};
+
+// validate the number grammar at p, return eOk or eInvalidValue
+// end is only used to know how many bytes can be read at once, the number itself stops at the first invalid character.
+int scan(const char* p, const char* end, Decimal& dec);
+
+// convert to the correctly rounded double, return false if it overflows
+bool toDouble(const Decimal& dec, double& result);
+
+// false if toDouble would overflow, only the numbers near the limit are converted to find out
+bool fitsDouble(const Decimal& dec);
+
+// exact integer conversion, return false if dec is not an integer or out of range
+// -0 is not an integer here, it stays a double to keep the sign.
+bool toInt64(const Decimal& dec, int64_t& result);
+bool toUint64(const Decimal& dec, uint64_t& result);
+
+}
+}
+#endif
@@ -1,10 +1,14 @@
 #include <assert.h>	// for assert
+#include <algorithm>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>	// for isdigit
-#include <errno.h>	// for errno, a macro that define a lvalue
-#include <math.h>	// for HUGE_VAL in C
 #include "JsonParser.h"
+#include "JsonDocument.h"
+#include "JsonFile.h"
+#include "JsonNumber.h"
+#include "JsonPointer.h"
+#include "JsonSimd.h"
+#include "JsonUtf8.h"
 
 namespace MyJson
 {
@@ -16,7 +20,22 @@ JsonParser::JsonParser() :
 	m_pCurLineHead(NULL),
 	m_curLine(0), 
 	m_curColumn(0),
-	m_CRLFStyle(eCRLFAll) {}
+	m_CRLFStyle(eCRLFAll),
+	m_engine(eRecursiveEngine),
+	m_pJsonBegin(NULL),
+	m_pJsonEnd(NULL),
+	m_pInSitu(NULL),
+	m_bBorrowStrings(false),
+	m_bValidateUtf8(true),
+	m_bPastEnd(false),
+	m_bCountLines(false),
+	m_maxDepth(kDefaultMaxDepth),
+	m_depth(0),
+	m_pArena(NULL),
+	m_structuralCount(0),
+	m_curStructural(0),
+	m_pProjection(NULL),
+	m_bReuseValues(false) {}
 
 JsonParser::~JsonParser() {}
 
@@ -24,64 +43,90 @@ JsonParser::~JsonParser() {}
 /*
 ws = *(%x20 / %x09 / %x0A / %x0D)
 ' ' / '\t' / '\r' / '\n'
+
+按块扫描：一次比较一个块（16/32字节）得到空白字符掩码，第一个非空白字符就是结束位置。
+行号统计：用换行符掩码的popcount计算行数，最后一个换行结束处为新的行首。
+	eCR			每个\r
+	eLF			每个\n
+	eCRLF		前一个字节为\r的\n
+	eCRLFAll	每个\r，以及前一个字节不是\r的\n
+跨块的\r\n通过carry传递到下一个块。
+行号只在出错时需要，所以默认解析时不统计，出错后再从文本开头按块统计到错误位置（locateError）。
+文本中的\r与\n只能出现在空白中（字符串中的是错误，就在错误位置），所以与在每段空白中统计的结果相同。
+两种情况仍在空白中统计（m_bCountLines）：原地解析时反转义会在缓冲区中写入\n，JsonPushParser已经丢弃了之前的文本。
 */
+static inline bool isWhiteSpace(char ch)
+{
+	return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+// the line breaks of a block, cr and lf only have the bits of the bytes to count
+static inline void countLineBreaks(LFStyle style, const char* block, Simd::Mask cr, Simd::Mask lf, Simd::Mask& carry,
+	int& line, const char*& lineHead)
+{
+	Simd::Mask crBefore = (cr << 1) | carry;
+	Simd::Mask heads = 0;
+	switch (style)
+	{
+	case eCR:
+		heads = cr;
+		line += Simd::popcount(cr);
+		break;
+	case eLF:
+		heads = lf;
+		line += Simd::popcount(lf);
+		break;
+	case eCRLF:
+		heads = lf & crBefore;
+		line += Simd::popcount(heads);
+		break;
+	case eCRLFAll:
+		heads = cr | lf;
+		line += Simd::popcount(cr) + Simd::popcount(lf & ~crBefore);
+		break;
+	}
+	if (heads)
+	{
+		lineHead = block + Simd::highestBit(heads) + 1;
+	}
+	carry = (cr >> (Simd::kBlockSize - 1)) & 1;
+}
+
 void JsonParser::parseWhiteSpace()
 {
 	const char* p = m_pJson;
-	while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+	if (!isWhiteSpace(peek())) // most calls find nothing to skip
+		return;
+
+	// the scan stops at the first other character or at the end of the input
+	const char* block = p;
+	Simd::Mask carry = 0; // '\r' at the last byte of the previous block
+	while (true)
 	{
-		if (m_CRLFStyle == eCR) // \r
-		{
-			if (*p == '\r')
-			{
-				p++;
-				m_curLine++;
-				m_pCurLineHead = p;
-				continue;
-			}
-		}
-		else if (m_CRLFStyle == eLF) // \n
+		Simd::Mask inRange;
+		Simd::Block b = Simd::loadBounded(block, m_pJsonEnd, inRange); // the bytes after the input are not white space
+		Simd::Mask cr = Simd::eqMask(b, '\r');
+		Simd::Mask lf = Simd::eqMask(b, '\n');
+		Simd::Mask ws = Simd::eqMask(b, ' ') | Simd::eqMask(b, '\t') | cr | lf;
+		Simd::Mask stop = ~ws & inRange;
+		if (m_bCountLines)
 		{
-			if (*p == '\n')
-			{
-				p++;
-				m_curLine++;
-				m_pCurLineHead = p;
-				continue;
-			}
+			Simd::Mask run = stop ? (inRange & Simd::beforeOffset(Simd::lowestBit(stop))) : inRange;
+			countLineBreaks(m_CRLFStyle, block, cr & run, lf & run, carry, m_curLine, m_pCurLineHead);
 		}
-		else if (m_CRLFStyle == eCRLF) // \r\n
+
+		if (stop)
 		{
-			if (*p == '\r' && *(p+1) == '\n')
-			{
-				p += 2;
-				m_curLine++;
-				m_pCurLineHead = p;
-				continue;
-			}
+			m_pJson = block + Simd::lowestBit(stop);
+			return;
 		}
-		else if (m_CRLFStyle == eCRLFAll) // \r\n \r \n
+		if (m_pJsonEnd - block <= (ptrdiff_t)Simd::kBlockSize)
 		{
-			if (*p == '\r')
-			{
-				p++;
-				m_curLine++;
-				if (*p == '\n')
-					p++;
-				m_pCurLineHead = p;
-				continue;
-			}
-			else if (*p == '\n')
-			{
-				p++;
-				m_curLine++;
-				m_pCurLineHead = p;
-				continue;
-			}
+			m_pJson = m_pJsonEnd;
+			return;
 		}
-		p++;
+		block += Simd::kBlockSize;
 	}
-	m_pJson = p;
 }
 
 // string literal: null / true / false
@@ -89,7 +134,7 @@ void JsonParser::parseWhiteSpace()
 need setType outside parseLiteral
 literal should not be "" or NULL
 */
-int JsonParser::parseLiteral(JsonValue& value, const char* literal, ValueType vType)
+int JsonParser::scanLiteral(const char* literal)
 {
 	assert(*m_pJson == literal[0]);
 	m_pJson++;
@@ -97,14 +142,21 @@ int JsonParser::parseLiteral(JsonValue& value, const char* literal, ValueType vT
 	int i = 0;
 	for (i = 0; literal[i]; i++) // literal[i] != '\0'
 	{
-		if (m_pJson[i] != literal[i])
+		if (m_pJson + i >= m_pJsonEnd || m_pJson[i] != literal[i])
 			return eInvalidValue;
 	}
 	m_pJson += i;
-	value.setType(vType);
 	return eOk;
 }
 
+int JsonParser::parseLiteral(JsonValue& value, const char* literal, ValueType vType)
+{
+	int ret = scanLiteral(literal);
+	if (ret == eOk)
+		value.setType(vType);
+	return ret;
+}
+
 // number
 /*
 number = ["-"] int [frac] [exp]
@@ -118,73 +170,80 @@ exp = ("e" / "E") ["-" / "+"] 1*digit
 只有整数部分是必需的
 整数部分0开始的话，只能是单个0
 
-需要考虑如何存储解析后结果 ---------> 简单起见，采用double，需要更精确的话应该分整型和浮点来存储
+存储：int64范围内的整数存为eInt64，超出int64但在uint64范围内的正整数存为eUint64，其余（包括-0）存为double。
 需要考虑分整型和浮点存储并且格式校验的话：number解析是整个parser中最难的部分。
 指数部分未禁止前导0，整数部分禁止前导0的原因是更久的JavaScript版本允许整数前导0来表示八进制，这种表示方式来自C语言。
 
-实现选择：
-1.naive解析，可能会有精度问题，参考https://github.com/google/double-conversion，可以考虑实现高精度大整数
-2.使用标准库strtod做转换 + 自己做校验。
-
-数字判断：isdigit
+实现：校验与转换在一次扫描中完成，不依赖locale，见JsonNumber.cpp。
 */
 int JsonParser::parseNumber(JsonValue& value)
 {
 	value.setType(eNull);
-	// validate number
-	const char* p = m_pJson;
-	// -
-	if (*p == '-')
-		p++;
-	// int = 0 / digit1-9 *digit
-	if (*p == '0')
-		p++;
-	else
-	{
-		if (!isdigit(*p)) // 1 - 9
-			return eInvalidValue;
-		for (p++; isdigit(*p); p++);
-	}
-	// frac = .1*digit
-	if (*p == '.')
+	Number::Decimal dec;
+	int ret = Number::scan(m_pJson, m_pJsonEnd, dec);
+	if (ret != eOk)
+		return ret;
+	// integers keep all their digits
+	int64_t i = 0;
+	uint64_t u = 0;
+	if (Number::toInt64(dec, i))
 	{
-		p++;
-		if (!isdigit(*p)) // at least one digit
-			return eInvalidValue;
-		for (p++; isdigit(*p); p++);
+		m_pJson = dec.end;
+		value.setInt64(i);
+		return eOk;
 	}
-	// exp = e/E [-/+] 1*digit
-	if (*p == 'e' || *p == 'E')
+	if (Number::toUint64(dec, u))
 	{
-		p++;
-		if (*p == '+' || *p == '-')
-			p++;
-		if (!isdigit(*p))
-			return eInvalidValue;
-		for (p++; isdigit(*p); p++);
+		m_pJson = dec.end;
+		value.setUint64(u);
+		return eOk;
 	}
-
-	// use strtod, overflow can be positive or negative 
-	errno = 0;
-	double ret = strtod(m_pJson, NULL);
-	if (errno == ERANGE && (ret == HUGE_VAL || ret == -HUGE_VAL))
-	{
+	// overflow can be positive or negative, underflow is just 0
+	double number = 0;
+	if (!Number::toDouble(dec, number))
 		return eNumberTooBig;
-	}
-	m_pJson = p;
+	m_pJson = dec.end;
 	value.setType(eNumber);
-	value.setNumber(ret);
+	value.setNumber(number);
 	return eOk;
 }
 
-bool JsonParser::parseHex4(const char* p, unsigned int & u)
+// where the decoded characters of a string go
+struct JsonParser::StringOutput // a new std::string
+{
+	std::string& str;
+	void append(const char* begin, const char* end) { str.append(begin, end); }
+	void push(char ch) { str += ch; }
+};
+
+struct JsonParser::InSituOutput // back into the input buffer, never ahead of the character being read
+{
+	char* pWrite;
+	void append(const char* begin, const char* end)
+	{
+		if (pWrite != begin) // nothing to move until the first escape
+			memmove(pWrite, begin, end - begin);
+		pWrite += end - begin;
+	}
+	void push(char ch) { *pWrite++ = ch; }
+};
+
+struct JsonParser::CheckOutput // nowhere, the string is only checked
+{
+	void append(const char*, const char*) {}
+	void push(char) {}
+};
+
+bool JsonParser::parseHex4(const char* p, const char* end, unsigned int & u)
 {
 	u = 0;
+	if (end - p < 4)
+		return false;
 	for (int i = 0; i < 4; i++)
 	{
 		char ch = *p++;
 		u <<= 4;
-		if (isdigit(ch))
+		if (Number::isDigit(ch))
 			u |= ch - '0';
 		else if (ch >= 'A' && ch <= 'F')
 			u |= ch - 'A' + 10;
@@ -197,32 +256,72 @@ bool JsonParser::parseHex4(const char* p, unsigned int & u)
 }
 
 void JsonParser::encodeUtf8(unsigned int u, std::string& parseStr)
+{
+	StringOutput out{ parseStr };
+	writeUtf8(u, out);
+}
+
+template<typename Output>
+void JsonParser::writeUtf8(unsigned int u, Output& out)
 {
 	if (u <= 0x7F)
 	{
-		parseStr += (char)(u & 0xFF);
+		out.push((char)(u & 0xFF));
 	}
 	else if (u <= 0x7FF)
 	{
-		parseStr += (char)(0xC0 | ((u >> 6) & 0xFF));
-		parseStr += (char)(0x80 | (u & 0x3F));
+		out.push((char)(0xC0 | ((u >> 6) & 0xFF)));
+		out.push((char)(0x80 | (u & 0x3F)));
 	}
 	else if (u <= 0xFFFF)
 	{
-		parseStr += (char)(0xE0 | ((u >> 12) & 0xFF));
-		parseStr += (char)(0x80 | ((u >> 6) & 0x3F));
-		parseStr += (char)(0x80 | (u & 0x3F));
+		out.push((char)(0xE0 | ((u >> 12) & 0xFF)));
+		out.push((char)(0x80 | ((u >> 6) & 0x3F)));
+		out.push((char)(0x80 | (u & 0x3F)));
 	}
 	else
 	{
 		assert(u <= 0x10FFFF);
-		parseStr += (char)(0xF0 | ((u >> 18) & 0xFF));
-		parseStr += (char)(0x80 | ((u >> 12) & 0x3F));
-		parseStr += (char)(0x80 | ((u >> 6) & 0x3F));
-		parseStr += (char)(0x80 | (u & 0x3F));
+		out.push((char)(0xF0 | ((u >> 18) & 0xFF)));
+		out.push((char)(0x80 | ((u >> 12) & 0x3F)));
+		out.push((char)(0x80 | ((u >> 6) & 0x3F)));
+		out.push((char)(0x80 | (u & 0x3F)));
+	}
+}
+
+// first byte at or after p whose bit is set in match(block), end if there is none
+template<typename Match>
+static inline const char* findFirst(const char* p, const char* end, Match match)
+{
+	if (p >= end)
+		return end;
+	while (true)
+	{
+		Simd::Mask inRange;
+		Simd::Mask found = match(Simd::loadBounded(p, end, inRange)) & inRange;
+		if (found)
+			return p + Simd::lowestBit(found);
+		if (end - p <= (ptrdiff_t)Simd::kBlockSize)
+			return end;
+		p += Simd::kBlockSize;
 	}
 }
 
+// first '\"', '\\' or control character at or after p, end if there is none
+// the characters before it are copied as they are
+static inline const char* findStringSpecial(const char* p, const char* end)
+{
+	return findFirst(p, end, [](const Simd::Block& b) {
+		return Simd::eqMask(b, '\"') | Simd::eqMask(b, '\\') | Simd::lessMask(b, 0x20);
+	});
+}
+
+// characters of a string without escapes, see setValidateUtf8
+bool JsonParser::isUtf8(const char* p, const char* end) const
+{
+	return !m_bValidateUtf8 || Utf8::findInvalid(p, end) == end;
+}
+
 // string
 /*
 string = quotation-mark *char quotation-mark
@@ -260,46 +359,160 @@ U+0000 ~ U+007F		7		0xxxxxxx										(与ASCII兼容)
 U+0080 ~ U+07FF		11		110xxxxx	10xxxxxx
 U+0800 ~ U+FFFF		16		1110xxxx	10xxxxxx	10xxxxxx
 U+10000 ~ U+10FFFF	21		11110xxx	10xxxxxx	10xxxxxx	10xxxxxx
+
+未转义的字符按原样保留，默认校验它们是有效的UTF-8（见JsonUtf8.cpp），出错时错误位置为无效序列的第一个字节。
 */
 int JsonParser::parseString(JsonValue& value)
 {
 	assert(*m_pJson == '\"');
 	m_pJson++;
-	std::string parseStr;
 	value.setType(eNull);
+	if (m_bBorrowStrings) // without escapes the string is exactly its source text
+	{
+		const char* run = findStringSpecial(m_pJson, m_pJsonEnd);
+		if (run < m_pJsonEnd && *run == '\"' && isUtf8(m_pJson, run))
+		{
+			value.setStringView(std::string_view(m_pJson, run - m_pJson));
+			m_pJson = run + 1;
+			return eOk;
+		}
+	}
+	if (m_pInSitu) // decode in place, the value refers to the caller's buffer
+	{
+		char* begin = m_pInSitu + (m_pJson - m_pJsonBegin);
+		InSituOutput out{ begin };
+		int ret = parseStringContent(out);
+		if (ret == eOk)
+			value.setStringView(std::string_view(begin, out.pWrite - begin));
+		return ret;
+	}
+	if (m_pArena) // decode into the reused buffer, then keep the characters in the document's arena
+	{
+		m_stringBuffer.clear();
+		StringOutput out{ m_stringBuffer };
+		int ret = parseStringContent(out);
+		if (ret == eOk)
+		{
+			char* str = (char*)m_pArena->allocate(m_stringBuffer.size() + 1, 1); // never a zero sized allocation
+			memcpy(str, m_stringBuffer.data(), m_stringBuffer.size());
+			value.setStringView(std::string_view(str, m_stringBuffer.size()));
+		}
+		return ret;
+	}
+	const char* run = findStringSpecial(m_pJson, m_pJsonEnd);
+	if (run < m_pJsonEnd && *run == '\"' && isUtf8(m_pJson, run)) // without escapes, copied from the text once
+	{
+		newString(value).assign(m_pJson, run);
+		m_pJson = run + 1;
+		return eOk;
+	}
+	m_stringBuffer.clear();
+	StringOutput out{ m_stringBuffer };
+	int ret = parseStringContent(out);
+	if (ret == eOk)
+		newString(value).assign(m_stringBuffer);
+	return ret;
+}
+
+// a string without a value: the view refers to the text if there is no escape, to the buffer of an in-situ parse,
+// or to m_stringBuffer which the next string overwrites
+int JsonParser::scanString(std::string_view& str)
+{
+	assert(*m_pJson == '\"');
+	m_pJson++;
+	const char* run = findStringSpecial(m_pJson, m_pJsonEnd);
+	if (run < m_pJsonEnd && *run == '\"' && isUtf8(m_pJson, run))
+	{
+		str = std::string_view(m_pJson, run - m_pJson);
+		m_pJson = run + 1;
+		return eOk;
+	}
+	if (m_pInSitu)
+	{
+		char* begin = m_pInSitu + (m_pJson - m_pJsonBegin);
+		InSituOutput out{ begin };
+		int ret = parseStringContent(out);
+		str = std::string_view(begin, out.pWrite - begin);
+		return ret;
+	}
+	m_stringBuffer.clear();
+	StringOutput out{ m_stringBuffer };
+	int ret = parseStringContent(out);
+	str = m_stringBuffer;
+	return ret;
+}
+
+// a scanned string kept as parseString would keep it
+void JsonParser::storeString(JsonValue& value, std::string_view str)
+{
+	bool inText = str.data() >= m_pJsonBegin && str.data() <= m_pJsonEnd;
+	if (inText && (m_bBorrowStrings || m_pInSitu))
+	{
+		value.setStringView(str);
+	}
+	else if (m_pArena)
+	{
+		char* copy = (char*)m_pArena->allocate(str.size() + 1, 1); // never a zero sized allocation
+		memcpy(copy, str.data(), str.size());
+		value.setStringView(std::string_view(copy, str.size()));
+	}
+	else
+	{
+		newString(value).assign(str);
+	}
+}
+
+template<typename Output>
+int JsonParser::parseStringContent(Output& out)
+{
 	const char* p = m_pJson; // point the character after "
+	const char* end = m_pJsonEnd;
 	while (true)
 	{
+		const char* run = findStringSpecial(p, end);
+		if (run == end)
+			return eMissQuatationMark;
+		if (m_bValidateUtf8)
+		{
+			const char* invalid = Utf8::findInvalid(p, run);
+			if (invalid != run)
+			{
+				m_pJson = invalid; // the error is at the sequence, not at the start of the string
+				return eInvalidUtf8;
+			}
+		}
+		out.append(p, run);
+		p = run;
 		char ch = *p++;
 		switch (ch)
 		{
 		case '\"': // end
-			value.setString(parseStr);
 			m_pJson = p;
 			return eOk;
 		case '\\': // escape characters
-			ch = *p++;
+			ch = p < end ? *p : '\0';
+			p++;
 			switch (ch)
 			{
-			case '\"':	parseStr += '\"'; break;
-			case '\\':	parseStr += '\\'; break;
-			case '/':	parseStr += '/';  break;
-			case 'b':	parseStr += '\b'; break;
-			case 'f':	parseStr += '\f'; break;
-			case 'n':	parseStr += '\n'; break;
-			case 'r':	parseStr += '\r'; break;
-			case 't':	parseStr += '\t'; break;
+			case '\"':	out.push('\"'); break;
+			case '\\':	out.push('\\'); break;
+			case '/':	out.push('/');  break;
+			case 'b':	out.push('\b'); break;
+			case 'f':	out.push('\f'); break;
+			case 'n':	out.push('\n'); break;
+			case 'r':	out.push('\r'); break;
+			case 't':	out.push('\t'); break;
 			case 'u': // unicode escapes
 				{
 					unsigned int u = 0, u2 = 0;
-					if (!parseHex4(p, u))
+					if (!parseHex4(p, end, u))
 					{
 						return eInvalidUniCodeHex;
 					}
 					p += 4;
 					if (u >= 0xD800 && u <= 0xDBFF) // surrogate pair
 					{
-						if (*p == '\\' && *(p + 1) == 'u' && parseHex4(p + 2, u2) && u2 >= 0xDC00 && u2 <= 0xDFFF)
+						if (end - p >= 2 && *p == '\\' && *(p + 1) == 'u' && parseHex4(p + 2, end, u2) && u2 >= 0xDC00 && u2 <= 0xDFFF)
 						{
 							p += 6;
 							u = 0x10000 + ((u - 0xD800) << 10) + (u2 - 0xDC00);
@@ -309,24 +522,51 @@ int JsonParser::parseString(JsonValue& value)
 							return eInvalidUniCodeSurrogate;
 						}
 					}
-					encodeUtf8(u, parseStr);
+					writeUtf8(u, out);
 					break;
 				}
 			default:
 				return eInvalidStringEscape;
 			}
 			break;
-		case '\0':
-			return eMissQuatationMark;
-		default:
-			if ((unsigned char)ch < 0x20)
-			{
-				return eInvalidStringChar;
-			}
-			parseStr += ch;
-			break;
+		default: // control characters, 0x00 ~ 0x1F
+			return eInvalidStringChar;
+		}
+	}
+}
+
+// children of the arrays and objects being parsed wait on m_stack (objects push key and value),
+// then move into a container allocated once with the exact size, or a spare one when values are reused.
+void JsonParser::popArray(JsonValue& value, size_t base)
+{
+	newContainer(value, eArray);
+	value.reserve(m_stack.size() - base);
+	for (size_t i = base; i < m_stack.size(); i++)
+		value.append(std::move(m_stack[i]));
+	m_stack.resize(base);
+}
+
+void JsonParser::popObject(JsonValue& value, size_t base)
+{
+	newContainer(value, eObject);
+	JsonValue::ObjectType& object = *value.m_payload.object;
+	object.reserve((m_stack.size() - base) / 2);
+	for (size_t i = base; i < m_stack.size(); i += 2)
+	{
+		JsonValue::Member* member = object.find(m_stack[i].getStringView());
+		if (member == nullptr)
+		{
+			object.add(std::move(m_stack[i]), std::move(m_stack[i + 1]));
+			continue;
+		}
+		if (m_bReuseValues) // the last value of a key is kept, the storage of the others is reused too
+		{
+			recycle(member->value);
+			recycle(m_stack[i]);
 		}
+		member->value = std::move(m_stack[i + 1]);
 	}
+	m_stack.resize(base);
 }
 
 // array
@@ -342,12 +582,13 @@ int JsonParser::parseArray(JsonValue& value)
 {
 	assert(*m_pJson == '[');
 	m_pJson++;
-	value.setType(eNull);
+	value.setNull();
 	parseWhiteSpace();
-	if (*m_pJson == ']') // empty array
+	size_t base = m_stack.size();
+	if (peek() == ']') // empty array
 	{
 		m_pJson++;
-		value.setType(eArray);
+		popArray(value, base);
 		return eOk;
 	}
 	while (true)
@@ -357,25 +598,26 @@ int JsonParser::parseArray(JsonValue& value)
 		int ret = parseValue(tmpValue);
 		if (ret != eOk)
 		{
-			value.setNull();
+			m_stack.push_back(std::move(tmpValue));
 			return ret;
 		}
+		m_stack.push_back(std::move(tmpValue));
 		parseWhiteSpace();
 
-		value.append(tmpValue);
-		if (*m_pJson == ']')
+		char ch = peek();
+		if (ch == ']')
 		{
 			m_pJson++;
+			popArray(value, base);
 			return eOk;
 		}
-		else if (*m_pJson == ',')
+		else if (ch == ',')
 		{
 			m_pJson++;
 		}
 		else
 		{
-			m_pJson++;
-			value.setNull();
+			skipUnexpected();
 			return eArrayMissCommaOrSquareBracket;
 		}
 	}
@@ -395,53 +637,41 @@ int JsonParser::parseObject(JsonValue& value)
 {
 	assert(*m_pJson == '{');
 	m_pJson++;
-	value.setType(eNull);
+	value.setNull();
 	parseWhiteSpace();
-	if (*m_pJson == '}')
+	size_t base = m_stack.size();
+	if (peek() == '}')
 	{
 		m_pJson++;
-		value.setType(eObject);
+		popObject(value, base);
 		return eOk;
 	}
 
 	int ret = eOk;
 	while (true)
 	{
-		parseWhiteSpace();
-		JsonValue tmpValue, keyValue;
-		if (*m_pJson != '\"')
-		{
-			ret = eObjectMissKey;
-			break;
-		}
-		ret = parseString(keyValue);
-		if (ret != eOk || !keyValue.isString())
-		{
-			break;
-		}
-
-		parseWhiteSpace();
-		if (*m_pJson != ':')
+		ret = parseMemberKey();
+		if (ret != eOk)
 		{
-			ret = eObjectMissColon;
 			break;
 		}
-		m_pJson++;
-
-		parseWhiteSpace();
+		JsonValue tmpValue;
 		ret = parseValue(tmpValue);
 		if (ret != eOk)
 		{
+			m_stack.push_back(std::move(tmpValue));
 			break;
 		}
-		value.appendKey(keyValue.getString(), tmpValue);
+		m_stack.push_back(std::move(tmpValue));
 		parseWhiteSpace();
-		if (*m_pJson == '}') // success
+		char ch = peek();
+		if (ch == '}') // success
 		{
 			m_pJson++;
+			popObject(value, base);
 			return eOk;
 		}
-		else if (*m_pJson == ',')
+		else if (ch == ',')
 		{
 			m_pJson++;
 		}
@@ -451,76 +681,1102 @@ int JsonParser::parseObject(JsonValue& value)
 			break;
 		}
 	}
-	value.setNull();
 	return ret;
 }
 
+// key of a member up to the start of its value, the key is pushed to m_stack
+int JsonParser::parseMemberKey()
+{
+	parseWhiteSpace();
+	if (peek() != '\"')
+	{
+		return eObjectMissKey;
+	}
+	JsonValue& keyValue = m_stack.emplace_back();
+	int ret = parseString(keyValue);
+	if (ret != eOk)
+	{
+		return ret;
+	}
+
+	parseWhiteSpace();
+	if (peek() != ':')
+	{
+		return eObjectMissColon;
+	}
+	m_pJson++;
+	parseWhiteSpace();
+	return eOk;
+}
+
 // value
 /*
 value = null / false / true / number / array / object
 */
 int JsonParser::parseValue(JsonValue& value)
 {
-	switch (*m_pJson)
+	switch (peek())
 	{
 	case 'n':	return parseLiteral(value, "null", eNull);
 	case 't':	return parseLiteral(value, "true", eTrue);
 	case 'f':	return parseLiteral(value, "false", eFalse);
 	case '\"':	return parseString(value);
-	case '\0':	return eExpectValue;
-	case '[':	return parseArray(value);
-	case '{':	return parseObject(value);
+	case '\0':	return m_pJson < m_pJsonEnd ? eInvalidValue : eExpectValue; // a NUL inside the text is not the end
+	case '[':
+	case '{':
+		{
+			if (m_depth >= m_maxDepth)
+				return eNestingTooDeep;
+			m_depth++;
+			int ret = *m_pJson == '[' ? parseArray(value) : parseObject(value);
+			m_depth--;
+			return ret;
+		}
 	default:	return parseNumber(value);
 	}
 }
 
+// iterative engine
+/*
+与递归下降的语法和错误位置完全相同，由事件解析器（见JsonParser.h中的parseValueEvents）驱动，用DomHandler构建value：
+	- 每个完整的value压到m_stack上（object的key也作为string value压入）
+	- endArray/endObject时把最后的子value移入按最终大小分配的容器，容器本身再压回m_stack
+嵌套深度只受m_maxDepth限制，不受线程栈大小限制。
+*/
+class JsonParser::DomHandler
+{
+public:
+	explicit DomHandler(JsonParser& parser) : m_parser(parser) {}
+	void null() { m_parser.m_stack.emplace_back(); }
+	void boolean(bool b) { m_parser.m_stack.emplace_back(b); }
+	void number(double d) { m_parser.m_stack.emplace_back(d); }
+	void int64(int64_t i) { m_parser.m_stack.emplace_back(i); }
+	void uint64(uint64_t u) { m_parser.m_stack.emplace_back(u); }
+	void string(std::string_view str) { m_parser.storeString(m_parser.m_stack.emplace_back(), str); }
+	void key(std::string_view key) { string(key); }
+	void startObject() {}
+	void endObject(size_t memberCount)
+	{
+		JsonValue object;
+		m_parser.popObject(object, m_parser.m_stack.size() - memberCount * 2);
+		m_parser.m_stack.push_back(std::move(object));
+	}
+	void startArray() {}
+	void endArray(size_t elementCount)
+	{
+		JsonValue array;
+		m_parser.popArray(array, m_parser.m_stack.size() - elementCount);
+		m_parser.m_stack.push_back(std::move(array));
+	}
+private:
+	JsonParser& m_parser;
+};
 
-int JsonParser::parseJson(JsonValue& value, const std::string& json)
+int JsonParser::parseIterative(JsonValue& value)
 {
-	m_curLine = 1;
-	m_curColumn = 1;
-	m_pJson = json.c_str();
-	value.setNull();
-	parseWhiteSpace();
-	int ret = parseValue(value);
+	size_t base = m_stack.size();
+	DomHandler handler(*this);
+	int ret = parseValueEvents(handler);
 	if (ret == eOk)
 	{
-		parseWhiteSpace();
-		if (*m_pJson != '\0')
+		value = std::move(m_stack.back());
+		m_stack.resize(base);
+	}
+	return ret;
+}
+
+// structural index engine
+/*
+stage 1: 一次扫描64字节，用SIMD得到各类字符的位掩码，找出所有结构字符的位置写入索引m_structurals：
+	- 字符串外的 { } [ ] : ,
+	- 字符串的起始引号
+	- 字符串外、紧跟在空白或结构字符之后的其他字符，即 null/true/false/number 的起始位置
+	转义：按顺序处理反斜杠，未被转义的反斜杠转义其后一个字符，被转义的引号不计入引号掩码。
+	字符串范围：引号掩码的前缀异或，包含起始引号与字符串内容，不包含结束引号。
+	最后追加文本末尾的偏移作为哨兵。索引按找到的结构字符增长，而不是按每字节一个预先分配；
+	偏移是32位，4 GiB及以上的文本直接使用递归引擎。
+stage 2: 按索引依次取出各个值的起始位置，不再扫描空白。
+	string/number/literal 仍使用parseString/parseNumber/parseLiteral解析，
+	解析结束的位置必须是下一个索引位置或者空白，否则该值之后紧跟了其他字符。
+
+任何错误都返回给parseRoot，由递归引擎重新解析以得到完全相同的错误与位置。
+*/
+// the characters escaped by a backslash in a chunk, backslashes are rare so handle them one by one
+// carry is 1 if the previous chunk ended with an unescaped backslash
+static inline uint64_t escapedMask(uint64_t backslash, uint64_t& carry)
+{
+	uint64_t escaped = carry;
+	carry = 0;
+	for (uint64_t bs = backslash & ~escaped; bs; bs &= bs - 1)
+	{
+		int i = Simd::lowestBit64(bs);
+		uint64_t bit = uint64_t(1) << i;
+		if (escaped & bit)
+			continue;
+		if (i == 63)
+			carry = 1;
+		else
+			escaped |= bit << 1;
+	}
+	return escaped;
+}
+
+// visit(offset) for each structural character in order, false if the last string is not closed
+template<typename Visit>
+static bool scanStructurals(const char* json, size_t len, Visit visit)
+{
+	uint64_t inStringCarry = 0;	// all ones if the previous chunk ended inside a string
+	uint64_t escapedCarry = 0;	// 1 if the previous chunk ended with an unescaped backslash
+	uint64_t separatorCarry = 1;	// 1 if the previous chunk ended with white space or structural character
+	char tail[Simd::kChunkSize];
+	for (size_t offset = 0; offset < len; offset += Simd::kChunkSize)
+	{
+		const char* p = json + offset;
+		if (len - offset < Simd::kChunkSize) // pad the last chunk with spaces
 		{
-			value.setNull();
-			ret = eRootNotSingular;
+			memset(tail, ' ', sizeof(tail));
+			memcpy(tail, p, len - offset);
+			p = tail;
+		}
+		Simd::Chunk chunk = Simd::loadChunk(p);
+		uint64_t backslash = Simd::chunkMask(chunk, [](const Simd::Block& b) { return Simd::eqMask(b, '\\'); });
+		uint64_t quote = Simd::chunkMask(chunk, [](const Simd::Block& b) { return Simd::eqMask(b, '\"'); });
+		uint64_t ws = Simd::chunkMask(chunk, [](const Simd::Block& b) {
+			return Simd::eqMask(b, ' ') | Simd::eqMask(b, '\t') | Simd::eqMask(b, '\r') | Simd::eqMask(b, '\n');
+		});
+		uint64_t ops = Simd::chunkMask(chunk, [](const Simd::Block& b) {
+			return Simd::eqMask(b, '{') | Simd::eqMask(b, '}') | Simd::eqMask(b, '[') | Simd::eqMask(b, ']')
+				| Simd::eqMask(b, ':') | Simd::eqMask(b, ',');
+		});
+
+		quote &= ~escapedMask(backslash, escapedCarry);
+
+		uint64_t inString = Simd::prefixXor(quote) ^ inStringCarry;
+		inStringCarry = uint64_t(0) - (inString >> 63);
+
+		uint64_t separator = ws | ops;
+		uint64_t scalarStart = ~(separator | quote) & ((separator << 1) | separatorCarry);
+		separatorCarry = separator >> 63;
+		uint64_t structural = ((ops | scalarStart) & ~inString) | (quote & inString);
+		if (p == tail) // the padding is not part of the text
+			structural &= (uint64_t(1) << (len - offset)) - 1;
+
+		for (; structural; structural &= structural - 1)
+		{
+			visit(offset + Simd::lowestBit64(structural));
 		}
 	}
-	m_pJson = NULL;
+	return !inStringCarry;
+}
+
+bool JsonParser::buildStructuralIndex(const char* json, size_t len)
+{
+	assert(len < UINT32_MAX);
+	// the index grows as the structurals are found, most text has one every few bytes rather than one per byte
+	if (m_structurals.size() < len / 8 + 64)
+		m_structurals.resize(len / 8 + 64);
+	uint32_t* pOut = m_structurals.data();
+	uint32_t* pLimit = pOut + m_structurals.size();
+	auto grow = [&]() {
+		size_t count = pOut - m_structurals.data();
+		m_structurals.resize(m_structurals.size() * 2);
+		pOut = m_structurals.data() + count;
+		pLimit = m_structurals.data() + m_structurals.size();
+	};
+	bool closed = scanStructurals(json, len, [&](size_t offset) {
+		if (pOut == pLimit)
+			grow();
+		*pOut++ = uint32_t(offset);
+	});
+	if (!closed) // unclosed string
+		return false;
+	if (pOut == pLimit)
+		grow();
+	*pOut++ = uint32_t(len);
+	m_structuralCount = pOut - m_structurals.data();
+	m_curStructural = 0;
+	return true;
+}
+
+int JsonParser::parseIndexedRoot(JsonValue& value)
+{
+	if (!buildStructuralIndex(m_pJsonBegin, m_pJsonEnd - m_pJsonBegin))
+		return eInvalidValue;
+	int ret = parseIndexedValue(value);
+	if (ret == eOk && m_curStructural != m_structuralCount - 1)
+		ret = eRootNotSingular;
 	return ret;
 }
 
-int JsonParser::parseJson(JsonValue& value, const std::string& json, std::string& errInfo)
+// a string/number/literal must be followed by the next structural character or white space
+int JsonParser::parseIndexedScalarEnd()
 {
-	m_curLine = 1;
-	m_curColumn = 1;
-	m_pJson = json.c_str();
-	m_pCurLineHead = m_pJson;
-	value.setNull();
-	parseWhiteSpace();
-	ParseResult ret = (ParseResult)parseValue(value);
-	if (ret == eOk)
+	if (m_pJson != m_pJsonBegin + m_structurals[m_curStructural] && !isWhiteSpace(peek()))
+		return eInvalidValue;
+	return eOk;
+}
+
+// the character at the i-th structural offset, '\0' for the sentinel at the end of the text
+char JsonParser::structuralChar(size_t i)
+{
+	const char* p = m_pJsonBegin + m_structurals[i];
+	return p < m_pJsonEnd ? *p : '\0';
+}
+
+int JsonParser::parseIndexedArray(JsonValue& value)
+{
+	size_t base = m_stack.size();
+	if (structuralChar(m_curStructural) == ']') // empty array
 	{
-		parseWhiteSpace();
-		if (*m_pJson != '\0')
+		m_curStructural++;
+		popArray(value, base);
+		return eOk;
+	}
+	while (true)
+	{
+		JsonValue tmpValue;
+		int ret = parseIndexedValue(tmpValue); // may push to m_stack, so not parsed in place there
+		m_stack.push_back(std::move(tmpValue));
+		if (ret != eOk)
+			break;
+		char ch = structuralChar(m_curStructural++);
+		if (ch == ']')
 		{
-			value.setNull();
-			ret = eRootNotSingular;
+			popArray(value, base);
+			return eOk;
 		}
+		else if (ch != ',')
+			break;
 	}
+	return eInvalidValue; // only success matters, the recursive engine reports the error
+}
 
-	std::string errorStr;
-	switch (ret)
+int JsonParser::parseIndexedObject(JsonValue& value)
+{
+	size_t base = m_stack.size();
+	if (structuralChar(m_curStructural) == '}') // empty object
 	{
-	case eExpectValue:
-		errorStr = "No value";
-		break;
+		m_curStructural++;
+		popObject(value, base);
+		return eOk;
+	}
+	while (true)
+	{
+		m_pJson = m_pJsonBegin + m_structurals[m_curStructural++];
+		if (peek() != '\"')
+			break;
+		if (parseString(m_stack.emplace_back()) != eOk || parseIndexedScalarEnd() != eOk)
+			break;
+		if (structuralChar(m_curStructural++) != ':')
+			break;
+		JsonValue tmpValue;
+		int ret = parseIndexedValue(tmpValue);
+		m_stack.push_back(std::move(tmpValue));
+		if (ret != eOk)
+			break;
+		char ch = structuralChar(m_curStructural++);
+		if (ch == '}')
+		{
+			popObject(value, base);
+			return eOk;
+		}
+		else if (ch != ',')
+			break;
+	}
+	return eInvalidValue; // only success matters, the recursive engine reports the error
+}
+
+int JsonParser::parseIndexedValue(JsonValue& value)
+{
+	if (m_curStructural >= m_structuralCount - 1) // only the sentinel left
+		return eExpectValue;
+	m_pJson = m_pJsonBegin + m_structurals[m_curStructural++];
+	int ret = eOk;
+	switch (*m_pJson)
+	{
+	case '[':
+	case '{':
+		{
+			if (m_depth >= m_maxDepth)
+				return eNestingTooDeep;
+			m_depth++;
+			ret = *m_pJson == '[' ? parseIndexedArray(value) : parseIndexedObject(value);
+			m_depth--;
+			return ret;
+		}
+	case ']':
+	case '}':
+	case ':':
+	case ',':	return eInvalidValue;
+	case 'n':	ret = parseLiteral(value, "null", eNull); break;
+	case 't':	ret = parseLiteral(value, "true", eTrue); break;
+	case 'f':	ret = parseLiteral(value, "false", eFalse); break;
+	case '\"':	ret = parseString(value); break;
+	default:	ret = parseNumber(value); break;
+	}
+	if (ret != eOk)
+		return ret;
+	return parseIndexedScalarEnd();
+}
+
+// top level array split (JsonArrayParser)
+/*
+用结构字符扫描找出根array的 [ 、第一层的 , 与结束的 ] 的位置，只记录这些位置而不是完整的结构索引。
+第一层以 [ { 加一、] } 减一计算，不检查括号类型：每个元素都要单独完整解析，括号不匹配时元素解析一定失败。
+根之前与之后只能有空白（其他字符都会出现在结构字符中）。
+*/
+bool JsonParser::splitArray(const char* json, size_t len, std::vector<size_t>& separators)
+{
+	separators.clear();
+	int depth = 0;
+	bool valid = true; // an array with nothing but white space after it
+	bool closed = false;
+	bool scanned = scanStructurals(json, len, [&](size_t offset) {
+		if (closed || !valid)
+		{
+			valid = false;
+			return;
+		}
+		switch (json[offset])
+		{
+		case '[':
+		case '{':
+			if (depth++ == 0)
+			{
+				valid = json[offset] == '[';
+				separators.push_back(offset);
+			}
+			break;
+		case ']':
+		case '}':
+			if (--depth == 0)
+			{
+				closed = true;
+				separators.push_back(offset);
+			}
+			break;
+		case ',':
+			if (depth == 1)
+				separators.push_back(offset);
+			break;
+		default:
+			valid = valid && depth > 0;
+			break;
+		}
+	});
+	return scanned && valid && closed;
+}
+
+// an element of the root array from json[begin] to json[end], which is the ',' or ']' after it
+int JsonParser::parseElement(JsonValue& value, const char* json, size_t len, size_t begin, size_t end)
+{
+	beginInput(json, len);
+	m_pJson = json + begin;
+	m_depth = 1; // inside the root array
+	parseWhiteSpace();
+	int ret = parseValue(value);
+	if (ret == eOk)
+	{
+		parseWhiteSpace();
+		if (m_pJson != json + end)
+			ret = eInvalidValue;
+	}
+	resetInput();
+	return ret;
+}
+
+// on-demand navigation (JsonLazyDocument)
+/*
+跳过m_pJson处的一个value而不构建它，也不完整校验它：
+	- string：按块查找引号与反斜杠，反斜杠跳过其后一个字符，直到未被转义的结束引号
+	- array/object：与结构索引相同，一次64字节得到字符串外的 [ { 与 ] } 的掩码，[ { 加一、] } 减一直到回到0，
+	  只有 ] } 的个数足以回到0时才逐个查看，不检查括号类型与逗号冒号
+	- null/true/false/number：到下一个空白、逗号、冒号或 ] } 为止，读取时才由parseValue校验
+跳过的部分中的错误不一定被发现，读取到的value总是与parseJson得到的相同。
+*/
+// one past the closing quote of the string whose content starts at p, NULL if it is not closed
+static const char* skipString(const char* p, const char* end)
+{
+	while (true)
+	{
+		p = findFirst(p, end, [](const Simd::Block& b) { return Simd::eqMask(b, '\"') | Simd::eqMask(b, '\\'); });
+		if (p == end)
+			return NULL;
+		if (*p == '\"')
+			return p + 1;
+		if (end - p < 2) // a backslash at the end
+			return NULL;
+		p += 2;
+	}
+}
+
+// one past the bracket that closes the array or object at p, NULL if it is not closed
+// 64 bytes at a time: brackets inside strings are masked off as in scanStructurals, and the brackets of a chunk are
+// only visited one by one if the chunk has enough closing brackets to end the container.
+static const char* skipContainer(const char* p, const char* end)
+{
+	const char* begin = p;
+	size_t len = end - begin;
+	size_t depth = 0;
+	uint64_t inStringCarry = 0;
+	uint64_t escapedCarry = 0;
+	char tail[Simd::kChunkSize];
+	for (size_t offset = 0; offset < len; offset += Simd::kChunkSize)
+	{
+		const char* chunkBegin = begin + offset;
+		if (len - offset < Simd::kChunkSize) // pad the last chunk with spaces
+		{
+			memset(tail, ' ', sizeof(tail));
+			memcpy(tail, chunkBegin, len - offset);
+			chunkBegin = tail;
+		}
+		Simd::Chunk chunk = Simd::loadChunk(chunkBegin);
+		uint64_t backslash = Simd::chunkMask(chunk, [](const Simd::Block& b) { return Simd::eqMask(b, '\\'); });
+		uint64_t quote = Simd::chunkMask(chunk, [](const Simd::Block& b) { return Simd::eqMask(b, '\"'); });
+		quote &= ~escapedMask(backslash, escapedCarry);
+		uint64_t inString = Simd::prefixXor(quote) ^ inStringCarry;
+		inStringCarry = uint64_t(0) - (inString >> 63);
+		uint64_t open = Simd::chunkMask(chunk, [](const Simd::Block& b) { return Simd::eqMask(b, '[') | Simd::eqMask(b, '{'); }) & ~inString;
+		uint64_t close = Simd::chunkMask(chunk, [](const Simd::Block& b) { return Simd::eqMask(b, ']') | Simd::eqMask(b, '}'); }) & ~inString;
+		size_t closeCount = Simd::popcount64(close);
+		if (closeCount < depth) // can not end in this chunk
+		{
+			depth += Simd::popcount64(open) - closeCount;
+			continue;
+		}
+		for (uint64_t brackets = open | close; brackets; brackets &= brackets - 1)
+		{
+			uint64_t bit = brackets & (0 - brackets);
+			if (open & bit)
+				depth++;
+			else if (--depth == 0)
+				return begin + offset + Simd::lowestBit64(bit) + 1;
+		}
+	}
+	return NULL;
+}
+
+int JsonParser::skipValue()
+{
+	char ch = peek();
+	if (ch == '\"')
+	{
+		const char* p = skipString(m_pJson + 1, m_pJsonEnd);
+		if (p == NULL)
+			return eMissQuatationMark;
+		m_pJson = p;
+		return eOk;
+	}
+	if (ch == '[' || ch == '{')
+	{
+		const char* end = skipContainer(m_pJson, m_pJsonEnd);
+		if (end == NULL)
+			return ch == '[' ? eArrayMissCommaOrSquareBracket : eObjectMissCommaOrCurlyBracket;
+		m_pJson = end;
+		return eOk;
+	}
+	switch (ch)
+	{
+	case '\0':
+		if (m_pJson == m_pJsonEnd)
+			return eExpectValue;
+		return eInvalidValue;
+	case ',':
+	case ':':
+	case ']':
+	case '}':
+		return eInvalidValue;
+	default:
+		while (m_pJson < m_pJsonEnd && !isWhiteSpace(*m_pJson) && *m_pJson != ',' && *m_pJson != ':' && *m_pJson != ']' && *m_pJson != '}')
+			m_pJson++;
+		return eOk;
+	}
+}
+
+// path projection
+/*
+setProjection给出一组JSON Pointer后，只构建这些路径的value以及通往它们的array与object：
+	- 路径合并为JsonPointerBatch的token树，从根开始，某个路径在该节点结束时用parseValue构建整个value
+	- object中只保留key与子节点匹配的成员，其余成员的key与value都不构建
+	- array中与子节点index匹配的元素被构建，在最大的index之前的其余元素以null占位，保持index不变，之后的元素不添加
+	- 路径经过的标量不是任何路径的value，在object中不保留，在array中以null占位
+所以对每个路径，在结果上resolve与在完整解析的结果上resolve得到相同的value（都不存在时都为nullptr），重复的key同样取最后一个。
+不需要的value由checkValue（见validate）校验后丢弃：只扫描不构建，不分配value、字符串与object的成员，
+所以结果、错误类型与错误位置都与不设置路径时的解析完全相同。设置路径时总是使用递归引擎。
+*/
+// a value at a node of the projection tree
+int JsonParser::parseProjected(JsonValue& value, uint32_t node)
+{
+	if (m_pProjection->m_nodes[node].firstPointer != JsonPointerBatch::kNone)
+		return parseValue(value);
+	char ch = peek();
+	if (ch != '[' && ch != '{')
+		return checkValue(); // a scalar on the way, value stays null
+	if (m_depth >= m_maxDepth)
+		return eNestingTooDeep;
+	m_depth++;
+	int ret = ch == '[' ? parseProjectedArray(value, node) : parseProjectedObject(value, node);
+	m_depth--;
+	return ret;
+}
+
+int JsonParser::parseProjectedArray(JsonValue& value, uint32_t node)
+{
+	const std::vector<JsonPointerBatch::Node>& nodes = m_pProjection->m_nodes;
+	size_t wanted = 0; // elements kept, up to the largest index of the children
+	for (uint32_t child = nodes[node].firstChild; child != JsonPointerBatch::kNone; child = nodes[child].nextSibling)
+	{
+		if (nodes[child].token.index != JsonPointer::kNoIndex && nodes[child].token.index >= wanted)
+			wanted = nodes[child].token.index + 1;
+	}
+	m_pJson++;
+	value.setType(eArray, containerResource());
+	parseWhiteSpace();
+	if (peek() == ']')
+	{
+		m_pJson++;
+		return eOk;
+	}
+	for (size_t i = 0; ; i++)
+	{
+		parseWhiteSpace();
+		uint32_t child = i < wanted ? nodes[node].firstChild : JsonPointerBatch::kNone;
+		while (child != JsonPointerBatch::kNone && nodes[child].token.index != i)
+			child = nodes[child].nextSibling;
+		int ret;
+		if (child != JsonPointerBatch::kNone)
+		{
+			JsonValue element;
+			ret = parseProjected(element, child);
+			value.append(std::move(element));
+		}
+		else
+		{
+			ret = checkValue();
+			if (i < wanted)
+				value.append(JsonValue());
+		}
+		if (ret != eOk)
+			return ret;
+		parseWhiteSpace();
+		char ch = peek();
+		if (ch == ']')
+		{
+			m_pJson++;
+			return eOk;
+		}
+		else if (ch == ',')
+		{
+			m_pJson++;
+		}
+		else
+		{
+			skipUnexpected();
+			return eArrayMissCommaOrSquareBracket;
+		}
+	}
+}
+
+int JsonParser::parseProjectedObject(JsonValue& value, uint32_t node)
+{
+	const std::vector<JsonPointerBatch::Node>& nodes = m_pProjection->m_nodes;
+	m_pJson++;
+	value.setType(eObject, containerResource());
+	parseWhiteSpace();
+	if (peek() == '}')
+	{
+		m_pJson++;
+		return eOk;
+	}
+	while (true)
+	{
+		parseWhiteSpace();
+		if (peek() != '\"')
+			return eObjectMissKey;
+		std::string_view key;
+		int ret = scanString(key);
+		if (ret != eOk)
+			return ret;
+		uint32_t child = nodes[node].firstChild;
+		while (child != JsonPointerBatch::kNone && nodes[child].token.key != key)
+			child = nodes[child].nextSibling;
+		JsonValue keyValue;
+		if (child != JsonPointerBatch::kNone)
+			storeString(keyValue, key); // before the view is overwritten by the strings of the value
+		parseWhiteSpace();
+		if (peek() != ':')
+			return eObjectMissColon;
+		m_pJson++;
+		parseWhiteSpace();
+		if (child != JsonPointerBatch::kNone)
+		{
+			JsonValue member;
+			ret = parseProjected(member, child);
+			if (ret != eOk)
+				return ret;
+			if (nodes[child].firstPointer != JsonPointerBatch::kNone || !member.isNull())
+				value.appendMember(std::move(keyValue), std::move(member));
+			else if (value.containsKey(keyValue.getStringView())) // a scalar replaces an earlier duplicate on the way
+				value.removeKey(std::string(keyValue.getStringView()));
+		}
+		else
+		{
+			ret = checkValue();
+			if (ret != eOk)
+				return ret;
+		}
+		parseWhiteSpace();
+		char ch = peek();
+		if (ch == '}')
+		{
+			m_pJson++;
+			return eOk;
+		}
+		else if (ch == ',')
+		{
+			m_pJson++;
+		}
+		else
+		{
+			return eObjectMissCommaOrCurlyBracket;
+		}
+	}
+}
+
+// value reuse
+/*
+setReuseValues(true)后，解析前先回收value中的存储，而不是直接释放：
+	- 有自己存储的string（含object的key）清空内容后保留容量，array与object清空元素后保留vector与哈希索引的容量，
+	  连同它们的节点一起移入m_spareStrings/m_spareArrays/m_spareObjects
+	- 解析时newString/newContainer先从这里取，没有时才分配
+	- 按解析使用的顺序回收：string按文本顺序，array与object按结束的顺序（后序），再翻转为栈，
+	  所以形状相同的文本中每个位置取回的正是上次在这个位置的存储，稳定后解析不再分配内存
+	- 借用的string与其他内存池中的array/object不回收；没有用完的存储留给之后的解析，总量不超过解析过的最大的value
+构建value的步骤与不回收时完全相同，重复的key、object的索引等行为都不变，重复的key被替换掉的value同样回收。解析到JsonDocument时不回收。
+解析失败时已经解析的部分留在m_stack上，由discardPartial按原来的顺序放回，结构索引引擎失败后由递归引擎重新解析之前也是如此。
+*/
+void JsonParser::recycle(JsonValue& value)
+{
+	size_t strings = m_spareStrings.size(), arrays = m_spareArrays.size(), objects = m_spareObjects.size();
+	recycleNodes(value);
+	std::reverse(m_spareStrings.begin() + strings, m_spareStrings.end());
+	std::reverse(m_spareArrays.begin() + arrays, m_spareArrays.end());
+	std::reverse(m_spareObjects.begin() + objects, m_spareObjects.end());
+}
+
+void JsonParser::recycleNodes(JsonValue& value)
+{
+	switch (value.type())
+	{
+	case eString:
+		if (!value.isBorrowedString())
+		{
+			value.m_payload.string->clear();
+			m_spareStrings.push_back(std::move(value));
+		}
+		break;
+	case eArray:
+		{
+			JsonValue::ArrayType& array = *value.m_payload.array;
+			for (JsonValue& element : array)
+				recycleNodes(element);
+			array.clear();
+			if (array.get_allocator().resource() == std::pmr::get_default_resource())
+				m_spareArrays.push_back(std::move(value));
+			break;
+		}
+	case eObject:
+		{
+			JsonValue::ObjectType& object = *value.m_payload.object;
+			for (JsonValue::Member& member : object)
+			{
+				recycleNodes(member.key);
+				recycleNodes(member.value);
+			}
+			object.clear();
+			if (object.resource() == std::pmr::get_default_resource())
+				m_spareObjects.push_back(std::move(value));
+			break;
+		}
+	default:
+		break;
+	}
+}
+
+// value, null before, becomes an empty owned string
+std::string& JsonParser::newString(JsonValue& value)
+{
+	if (m_spareStrings.empty())
+	{
+		value.setString(std::string());
+	}
+	else
+	{
+		value = std::move(m_spareStrings.back());
+		m_spareStrings.pop_back();
+	}
+	return *value.m_payload.string;
+}
+
+// value becomes an empty array or object of containerResource()
+void JsonParser::newContainer(JsonValue& value, ValueType t)
+{
+	std::vector<JsonValue>& spares = t == eArray ? m_spareArrays : m_spareObjects;
+	if (spares.empty() || m_pArena)
+	{
+		value.setType(t, containerResource());
+		return;
+	}
+	value = std::move(spares.back());
+	spares.pop_back();
+}
+
+// validation
+/*
+validate与checkValue只校验语法，不构建value：
+	- string用CheckOutput走一遍parseStringContent，转义与代理对同样校验，但不解码到任何缓冲区
+	- number只做Number::scan的语法扫描，只有接近double上限的数才需要转换来判断是否溢出（Number::fitsDouble）
+	- 与事件解析相同，用m_frames作为显式栈，不受线程栈限制，嵌套深度从m_depth开始计算
+语法的每一步与parseValue一一对应，所以结果与错误位置都与parseJson完全相同。
+*/
+int JsonParser::checkScalar()
+{
+	switch (peek())
+	{
+	case 'n':	return scanLiteral("null");
+	case 't':	return scanLiteral("true");
+	case 'f':	return scanLiteral("false");
+	case '\"':
+		{
+			m_pJson++;
+			CheckOutput out;
+			return parseStringContent(out);
+		}
+	case '\0':	return m_pJson < m_pJsonEnd ? eInvalidValue : eExpectValue;
+	default:
+		{
+			Number::Decimal dec;
+			int ret = Number::scan(m_pJson, m_pJsonEnd, dec);
+			if (ret != eOk)
+				return ret;
+			if (!Number::fitsDouble(dec))
+				return eNumberTooBig;
+			m_pJson = dec.end;
+			return eOk;
+		}
+	}
+}
+
+// key of a member up to the start of its value
+int JsonParser::checkKey()
+{
+	parseWhiteSpace();
+	if (peek() != '\"')
+		return eObjectMissKey;
+	m_pJson++;
+	CheckOutput out;
+	int ret = parseStringContent(out);
+	if (ret != eOk)
+		return ret;
+	parseWhiteSpace();
+	if (peek() != ':')
+		return eObjectMissColon;
+	m_pJson++;
+	parseWhiteSpace();
+	return eOk;
+}
+
+// one value from m_pJson, the same steps as parseValueEvents
+int JsonParser::checkValue()
+{
+	m_frames.clear();
+	int ret = eOk;
+	while (true)
+	{
+		char ch = peek();
+		if (ch == '[' || ch == '{')
+		{
+			if (m_depth + m_frames.size() >= m_maxDepth)
+				return eNestingTooDeep;
+			bool object = ch == '{';
+			m_pJson++;
+			parseWhiteSpace();
+			if (peek() != (object ? '}' : ']'))
+			{
+				m_frames.push_back({ 0, object });
+				ret = object ? checkKey() : eOk;
+				if (ret != eOk)
+					return ret;
+				parseWhiteSpace();
+				continue;
+			}
+			m_pJson++;
+		}
+		else
+		{
+			ret = checkScalar();
+			if (ret != eOk)
+				return ret;
+		}
+
+		while (!m_frames.empty())
+		{
+			bool object = m_frames.back().object;
+			parseWhiteSpace();
+			char ch = peek();
+			if (ch == ',')
+			{
+				m_pJson++;
+				ret = object ? checkKey() : eOk;
+				if (ret != eOk)
+					return ret;
+				parseWhiteSpace();
+				break;
+			}
+			else if (ch == (object ? '}' : ']'))
+			{
+				m_pJson++;
+				m_frames.pop_back();
+			}
+			else if (object)
+			{
+				return eObjectMissCommaOrCurlyBracket;
+			}
+			else
+			{
+				skipUnexpected();
+				return eArrayMissCommaOrSquareBracket;
+			}
+		}
+		if (m_frames.empty())
+			return eOk;
+	}
+}
+
+// the text ends at json + len, it needs no '\0' after it
+void JsonParser::beginInput(const char* json, size_t len)
+{
+	m_curLine = 1;
+	m_curColumn = 0;
+	m_bPastEnd = false;
+	m_pJson = json;
+	m_pJsonBegin = json;
+	m_pJsonEnd = json + len;
+	m_pCurLineHead = m_pJson;
+	m_depth = 0;
+}
+
+int JsonParser::parseRoot(JsonValue& value, const char* json, size_t len)
+{
+	beginInput(json, len);
+	if (m_bReuseValues && !m_pArena)
+		recycle(value);
+	value.setNull();
+	// the index engine only reports success, any error is reported by parsing again with the recursive engine,
+	// so both engines give the same error and position.
+	// an in-situ parse can not run twice over a buffer it has already changed, so it never uses the index engine.
+	// the index holds 32 bit offsets, a text of 4 GiB or more is parsed by the recursive engine.
+	if (m_engine == eStructuralIndexEngine && !m_pInSitu && !m_pProjection && len < UINT32_MAX)
+	{
+		if (parseIndexedRoot(value) == eOk)
+		{
+			locateError(eOk);
+			return eOk;
+		}
+		discardPartial(value);
+	}
+	m_pJson = json;
+	m_depth = 0;
+	parseWhiteSpace();
+	int ret;
+	if (m_pProjection)
+		ret = parseProjected(value, 0); // the containers on the way are built before their elements
+	else
+		ret = m_engine == eIterativeEngine ? parseIterative(value) : parseValue(value);
+	if (ret == eOk)
+	{
+		parseWhiteSpace();
+		if (m_pJson != m_pJsonEnd)
+			ret = eRootNotSingular;
+	}
+	if (ret != eOk)
+		discardPartial(value);
+	locateError(ret);
+	return ret;
+}
+
+// an error leaves the values parsed before it on m_stack, and value may be partly built,
+// their storage goes back to the spares when values are reused, in the order the next parse takes it
+void JsonParser::discardPartial(JsonValue& value)
+{
+	if (m_bReuseValues && !m_pArena)
+	{
+		for (size_t i = m_stack.size(); i-- > 0;)
+			recycle(m_stack[i]);
+		recycle(value);
+	}
+	value.setNull();
+	m_stack.clear();
+}
+
+// the error of a missing comma is after the character found instead of it, the end of the text counts as a character there
+void JsonParser::skipUnexpected()
+{
+	if (m_pJson < m_pJsonEnd)
+		m_pJson++;
+	else
+		m_bPastEnd = true;
+}
+
+// line and column of the error at m_pJson, the lines are counted from the start of the text unless they were counted while parsing
+void JsonParser::locateError(int result)
+{
+	if (result == eOk)
+	{
+		m_curLine = 0;
+		m_curColumn = 0;
+		return;
+	}
+	if (!m_bCountLines)
+	{
+		m_curLine = 1;
+		m_pCurLineHead = m_pJsonBegin;
+		Simd::Mask carry = 0;
+		const char* end = std::min(m_pJson, m_pJsonEnd); // never a byte outside the text
+		for (const char* block = m_pJsonBegin; block < end; block += std::min<ptrdiff_t>(end - block, Simd::kBlockSize))
+		{
+			Simd::Mask inRange;
+			Simd::Block b = Simd::loadBounded(block, end, inRange);
+			countLineBreaks(m_CRLFStyle, block, Simd::eqMask(b, '\r') & inRange, Simd::eqMask(b, '\n') & inRange, carry,
+				m_curLine, m_pCurLineHead);
+		}
+	}
+	m_curColumn = int(m_pJson - m_pCurLineHead + 1 + m_bPastEnd);
+}
+
+void JsonParser::resetInput()
+{
+	m_pJson = NULL;
+	m_pJsonBegin = NULL;
+	m_pJsonEnd = NULL;
+	m_pInSitu = NULL;
+	m_pArena = NULL;
+	m_stack.clear(); // keeps its capacity for the next parse
+}
+
+int JsonParser::parseJson(JsonValue& value, std::string_view json)
+{
+	int ret = parseRoot(value, json.data(), json.size());
+	resetInput();
+	return ret;
+}
+
+int JsonParser::parseJson(JsonValue& value, std::string_view json, std::string& errInfo)
+{
+	int ret = parseRoot(value, json.data(), json.size());
+	makeErrorInfo(ret, errInfo);
+	resetInput();
+	return ret;
+}
+
+int JsonParser::parseJson(JsonValue& value, const char* json, size_t len)
+{
+	return parseJson(value, std::string_view(json, len));
+}
+
+int JsonParser::parseJson(JsonValue& value, const char* json, size_t len, std::string& errInfo)
+{
+	return parseJson(value, std::string_view(json, len), errInfo);
+}
+
+// strings are unescaped in place and refer to buf, the text ends at buf + len
+int JsonParser::parseJsonInSitu(JsonValue& value, char* buf, size_t len)
+{
+	m_pInSitu = buf;
+	m_bCountLines = true; // the unescaped strings before an error may have put line breaks in buf
+	int ret = parseRoot(value, buf, len);
+	m_bCountLines = false;
+	resetInput();
+	return ret;
+}
+
+// the arena of doc is released before parsing
+int JsonParser::parseJson(JsonDocument& doc, std::string_view json)
+{
+	doc.clear();
+	m_pArena = doc.resource();
+	int ret = parseRoot(doc.m_root, json.data(), json.size()); // containers and strings all in the arena, doc stays arena only
+	resetInput();
+	return ret;
+}
+
+int JsonParser::parseJson(JsonDocument& doc, std::string_view json, std::string& errInfo)
+{
+	doc.clear();
+	m_pArena = doc.resource();
+	int ret = parseRoot(doc.m_root, json.data(), json.size()); // containers and strings all in the arena, doc stays arena only
+	makeErrorInfo(ret, errInfo);
+	resetInput();
+	return ret;
+}
+
+int JsonParser::parseFile(JsonValue& value, const char* path)
+{
+	std::string errInfo;
+	return parseFile(value, path, errInfo);
+}
+
+int JsonParser::validate(std::string_view json)
+{
+	std::string errInfo;
+	return validate(json, errInfo);
+}
+
+int JsonParser::validate(std::string_view json, std::string& errInfo)
+{
+	beginInput(json.data(), json.size());
+	parseWhiteSpace();
+	int ret = checkValue();
+	if (ret == eOk)
+	{
+		parseWhiteSpace();
+		if (m_pJson != m_pJsonEnd)
+			ret = eRootNotSingular;
+	}
+	locateError(ret);
+	makeErrorInfo(ret, errInfo);
+	resetInput();
+	return ret;
+}
+
+// the text is a view of the mapping, see MappedFile
+int JsonParser::parseFile(JsonValue& value, const char* path, std::string& errInfo)
+{
+	value.setNull();
+	MappedFile file;
+	if (!file.open(path))
+	{
+		makeErrorInfo(eFileError, errInfo);
+		return eFileError;
+	}
+	bool borrow = m_bBorrowStrings;
+	m_bBorrowStrings = false; // no value may refer to the mapping
+	int ret = parseRoot(value, file.data(), file.size());
+	m_bBorrowStrings = borrow;
+	makeErrorInfo(ret, errInfo);
+	resetInput();
+	return ret;
+}
+
+void JsonParser::makeErrorInfo(int result, std::string& errInfo)
+{
+	ParseResult ret = (ParseResult)result;
+	std::string errorStr;
+	switch (ret)
+	{
+	case eExpectValue:
+		errorStr = "No value";
+		break;
 	case eInvalidValue:
 		errorStr = "Invalid value";
 		break;
@@ -557,14 +1813,28 @@ int JsonParser::parseJson(JsonValue& value, const std::string& json, std::string
 	case eObjectMissCommaOrCurlyBracket:
 		errorStr = "Object miss comma(,) or curly bracket(})";
 		break;
+	case eNestingTooDeep:
+		errorStr = "Nesting of arrays and objects is too deep";
+		break;
+	case eFileError:
+		errorStr = "Can not read the file";
+		break;
+	case eInvalidUtf8:
+		errorStr = "Invalid UTF-8 in string";
+		break;
 	default:
 		break;
 	}
 	
 	errInfo.clear();
-	if (ret != eOk)
+	if (ret == eFileError) // no position in a text
+	{
+		m_curLine = 0;
+		m_curColumn = 0;
+		errInfo = errorStr + ".";
+	}
+	else if (ret != eOk) // located by the parse
 	{
-		m_curColumn = int(m_pJson - m_pCurLineHead + 1);
 		errInfo += "line "s + std::to_string(m_curLine);
 		errInfo += ", column "s + std::to_string(m_curColumn);
 		errInfo += ": "s + errorStr + ".";
@@ -574,9 +1844,6 @@ int JsonParser::parseJson(JsonValue& value, const std::string& json, std::string
 		m_curLine = 0;
 		m_curColumn = 0;
 	}
-
-	m_pJson = NULL;
-	return ret;
 }
 
 int JsonParser::errorLine()
@@ -594,4 +1861,46 @@ void JsonParser::setParseLFStyle(LFStyle style)
 	m_CRLFStyle = (style < eCR || style > eCRLFAll) ? eCRLFAll : style;
 }
 
+void JsonParser::setParseEngine(ParseEngine engine)
+{
+	m_engine = (engine < eRecursiveEngine || engine > eIterativeEngine) ? eRecursiveEngine : engine;
+}
+
+// arrays and objects nested deeper than depth give eNestingTooDeep in all engines.
+// the recursive and index engines use the thread stack for each level, only the iterative engine is safe for a large limit.
+void JsonParser::setMaxDepth(size_t depth)
+{
+	m_maxDepth = depth;
+}
+
+// strings without escapes and keys refer to the parsed text, which must outlive the value
+void JsonParser::setBorrowStrings(bool borrow)
+{
+	m_bBorrowStrings = borrow;
+}
+
+// off: the bytes of strings from 0x80 are kept as they are, for text in other 8 bit encodings
+void JsonParser::setValidateUtf8(bool validate)
+{
+	m_bValidateUtf8 = validate;
+}
+
+// the storage kept for reuse is released when reuse is turned off
+void JsonParser::setReuseValues(bool reuse)
+{
+	m_bReuseValues = reuse;
+	if (!reuse)
+	{
+		m_spareStrings = std::vector<JsonValue>();
+		m_spareArrays = std::vector<JsonValue>();
+		m_spareObjects = std::vector<JsonValue>();
+	}
+}
+
+// paths must outlive the parses that use it, see parseProjected
+void JsonParser::setProjection(const JsonPointerBatch* paths)
+{
+	m_pProjection = paths;
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,267 @@
+#include "JsonPointer.h"
+#include "JsonDocument.h"
+#include <functional>
+#include <string.h>
+#include <utility>
+
+namespace MyJson
+{
+
+// JSON Pointer
+/*
+按RFC 6901解析："" 表示整个value，否则每个token以'/'开始，token中"~1"表示'/'，"~0"表示'~'，其余的'~'都是错误。
+解析时为每个token计算好：
+	- 反转义后的key与它的std::hash<std::string_view>，与object的哈希索引使用同一个哈希，大object查找时不再计算哈希
+	- array的index：非空、全是数字、没有前导0且不溢出时才是index，"-"与其他token都不是index
+查找时array使用index，object使用key（数字token在object中也是key），类型不符或不存在时得到nullptr。
+*/
+JsonPointer::JsonPointer() :
+	m_bValid(true) {}
+
+JsonPointer::JsonPointer(std::string_view pointer) :
+	m_bValid(true)
+{
+	if (pointer.empty())
+		return;
+	if (pointer[0] != '/')
+	{
+		m_bValid = false;
+		return;
+	}
+	size_t pos = 1;
+	while (true)
+	{
+		size_t end = pointer.find('/', pos);
+		if (end == std::string_view::npos)
+			end = pointer.size();
+		std::string key;
+		key.reserve(end - pos);
+		for (size_t i = pos; i < end; i++)
+		{
+			char ch = pointer[i];
+			if (ch == '~')
+			{
+				if (i + 1 == end || (pointer[i + 1] != '0' && pointer[i + 1] != '1'))
+				{
+					m_tokens.clear();
+					m_bValid = false;
+					return;
+				}
+				ch = pointer[++i] == '0' ? '~' : '/';
+			}
+			key.push_back(ch);
+		}
+		m_tokens.push_back(makeToken(std::move(key)));
+		if (end == pointer.size())
+			break;
+		pos = end + 1;
+	}
+}
+
+bool JsonPointer::isValid() const
+{
+	return m_bValid;
+}
+
+size_t JsonPointer::size() const
+{
+	return m_tokens.size();
+}
+
+std::string_view JsonPointer::token(size_t i) const
+{
+	return m_tokens[i].key;
+}
+
+const JsonValue* JsonPointer::resolve(const JsonValue& root) const
+{
+	if (!m_bValid)
+		return nullptr;
+	const JsonValue* value = &root;
+	for (const Token& token : m_tokens)
+	{
+		value = step(*value, token);
+		if (value == nullptr)
+			return nullptr;
+	}
+	return value;
+}
+
+JsonValue* JsonPointer::resolve(JsonValue& root) const
+{
+	return const_cast<JsonValue*>(resolve(std::as_const(root)));
+}
+
+JsonValue* JsonPointer::resolveOrCreate(JsonValue& root) const
+{
+	return create(root, std::pmr::get_default_resource(), nullptr);
+}
+
+// the parser and this are the only writers that keep the tree of a document arena only
+JsonValue* JsonPointer::resolveOrCreate(JsonDocument& doc) const
+{
+	return create(doc.m_root, doc.resource(), doc.resource());
+}
+
+// resource: for a null root, arena: the resource whose objects get keys borrowed from it, nullptr for none
+JsonValue* JsonPointer::create(JsonValue& root, std::pmr::memory_resource* resource, std::pmr::memory_resource* arena) const
+{
+	if (!m_bValid)
+		return nullptr;
+	JsonValue* value = &root;
+	for (const Token& token : m_tokens)
+	{
+		value = stepOrCreate(*value, token, resource, arena);
+		if (value == nullptr)
+			return nullptr;
+	}
+	return value;
+}
+
+JsonPointer::Token JsonPointer::makeToken(std::string key)
+{
+	Token token;
+	token.hash = std::hash<std::string_view>()(key);
+	token.index = kNoIndex;
+	if (!key.empty() && (key[0] != '0' || key.size() == 1))
+	{
+		size_t index = 0;
+		bool digits = true;
+		for (char ch : key)
+		{
+			if (ch < '0' || ch > '9' || index > (kNoIndex - 1 - (ch - '0')) / 10)
+			{
+				digits = false;
+				break;
+			}
+			index = index * 10 + (ch - '0');
+		}
+		if (digits)
+			token.index = index;
+	}
+	token.key = std::move(key);
+	return token;
+}
+
+const JsonValue* JsonPointer::step(const JsonValue& value, const Token& token)
+{
+	if (value.type() == eObject)
+	{
+		const JsonValue::Member* member = value.m_payload.object->find(token.key, token.hash);
+		return member ? &member->value : nullptr;
+	}
+	if (value.type() == eArray)
+		return token.index < value.m_payload.array->size() ? &(*value.m_payload.array)[token.index] : nullptr;
+	return nullptr;
+}
+
+// a null takes the memory resource of the container it is in, so the members created in a JsonDocument use its arena
+JsonValue* JsonPointer::stepOrCreate(JsonValue& value, const Token& token, std::pmr::memory_resource*& resource,
+	std::pmr::memory_resource* arena)
+{
+	if (value.type() == eNull)
+		value.setType(token.index != kNoIndex || token.key == "-" ? eArray : eObject, resource);
+	if (value.type() == eObject)
+	{
+		JsonValue::ObjectType& object = *value.m_payload.object;
+		resource = object.resource();
+		JsonValue::Member* member = object.find(token.key, token.hash);
+		if (member)
+			return &member->value;
+		JsonValue key;
+		if (resource != arena) // an owned key, released with the object
+			key.setString(token.key);
+		else // the characters live as long as the arena, like the strings the parser keeps in a JsonDocument
+		{
+			char* copy = (char*)resource->allocate(token.key.size() + 1, 1); // never a zero sized allocation
+			memcpy(copy, token.key.data(), token.key.size());
+			key.setStringView(std::string_view(copy, token.key.size()));
+		}
+		return &object.add(std::move(key), JsonValue());
+	}
+	if (value.type() == eArray)
+	{
+		JsonValue::ArrayType& array = *value.m_payload.array;
+		resource = array.get_allocator().resource();
+		if (token.key == "-" || token.index == array.size())
+			return &array.emplace_back();
+		return token.index < array.size() ? &array[token.index] : nullptr;
+	}
+	return nullptr;
+}
+
+JsonPointerBatch::JsonPointerBatch()
+{
+	clear();
+}
+
+size_t JsonPointerBatch::add(const JsonPointer& pointer)
+{
+	uint32_t position = uint32_t(m_nextPointer.size());
+	if (!pointer.isValid())
+	{
+		m_nextPointer.push_back(kNone); // in no node, always nullptr
+		return position;
+	}
+	uint32_t node = 0;
+	for (const JsonPointer::Token& token : pointer.m_tokens)
+	{
+		uint32_t child = m_nodes[node].firstChild;
+		uint32_t last = kNone;
+		while (child != kNone && m_nodes[child].token.key != token.key)
+		{
+			last = child;
+			child = m_nodes[child].nextSibling;
+		}
+		if (child == kNone)
+		{
+			child = uint32_t(m_nodes.size());
+			m_nodes.push_back(Node{ token, kNone, kNone, kNone });
+			if (last == kNone)
+				m_nodes[node].firstChild = child;
+			else
+				m_nodes[last].nextSibling = child;
+		}
+		node = child;
+	}
+	m_nextPointer.push_back(m_nodes[node].firstPointer);
+	m_nodes[node].firstPointer = position;
+	return position;
+}
+
+size_t JsonPointerBatch::add(std::string_view pointer)
+{
+	return add(JsonPointer(pointer));
+}
+
+size_t JsonPointerBatch::size() const
+{
+	return m_nextPointer.size();
+}
+
+void JsonPointerBatch::clear()
+{
+	m_nodes.assign(1, Node{ JsonPointer::Token{ std::string(), 0, JsonPointer::kNoIndex }, kNone, kNone, kNone });
+	m_nextPointer.clear();
+}
+
+void JsonPointerBatch::resolve(const JsonValue& root, std::vector<const JsonValue*>& results) const
+{
+	results.assign(m_nextPointer.size(), nullptr);
+	visit(0, &root, results);
+}
+
+// depth first, a subtree whose value is not there is not visited
+void JsonPointerBatch::visit(uint32_t node, const JsonValue* value, std::vector<const JsonValue*>& results) const
+{
+	for (uint32_t pointer = m_nodes[node].firstPointer; pointer != kNone; pointer = m_nextPointer[pointer])
+		results[pointer] = value;
+	for (uint32_t child = m_nodes[node].firstChild; child != kNone; child = m_nodes[child].nextSibling)
+	{
+		const JsonValue* childValue = JsonPointer::step(*value, m_nodes[child].token);
+		if (childValue)
+			visit(child, childValue, results);
+	}
+}
+
+}
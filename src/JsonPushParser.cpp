@@ -0,0 +1,347 @@
+#include <string.h>
+#include "JsonPushParser.h"
+
+namespace MyJson
+{
+
+// push parser
+/*
+与事件解析器（JsonParser::parseValueEvents）相同的步骤，只是把“下一步要解析什么”保存在m_state中，文本不足时停下，等下一块文本到来后继续：
+	- 每个状态都先跳过空白，如果空白一直到已有文本的末尾，则回退到空白之前停下，下一块到来后重新跳过，行号统计与一次解析完全相同
+	- string/number/literal 只在能看到其结束位置时才解析：string要有未被转义的结束引号，number与literal之后要有一个不属于它的字符，
+	  否则保留从它开始的文本，m_scanned记录已经查找过的位置，长string跨越很多块时不会重复查找
+	- 已经解析的value与未结束的array/object保存在m_parser的m_stack与m_frames上，与JsonParser的迭代引擎相同
+	- finish时不再等待，剩余文本在m_pJsonEnd处结束，与一次解析整个文本得到相同的结果与错误位置
+*/
+JsonPushParser::JsonPushParser() :
+	m_offset(0),
+	m_scanned(0),
+	m_lineHead(0),
+	m_state(eStateValue),
+	m_result(eOk),
+	m_bFinishing(false),
+	m_errorLine(0),
+	m_errorColumn(0)
+{
+	m_parser.m_bCountLines = true; // the text before the current chunk is gone when an error is found
+	reset();
+}
+
+JsonPushParser::~JsonPushParser() {}
+
+void JsonPushParser::reset()
+{
+	m_buffer.clear();
+	m_offset = 0;
+	m_scanned = 0;
+	m_lineHead = 0;
+	m_state = eStateValue;
+	m_result = eOk;
+	m_bFinishing = false;
+	m_parser.m_curLine = 1;
+	m_parser.m_stack.clear();
+	m_parser.m_frames.clear();
+}
+
+int JsonPushParser::feed(const char* data, size_t len)
+{
+	if (m_result != eOk || m_state == eStateDone)
+		return m_result;
+	m_buffer.append(data, len);
+	return parse();
+}
+
+int JsonPushParser::finish(JsonValue& value)
+{
+	value.setNull();
+	if (m_result == eOk && m_state != eStateDone)
+	{
+		m_bFinishing = true;
+		parse();
+	}
+	int ret = m_result;
+	if (ret == eOk)
+	{
+		value = std::move(m_parser.m_stack.back());
+		m_errorLine = 0;
+		m_errorColumn = 0;
+	}
+	reset();
+	return ret;
+}
+
+int JsonPushParser::errorLine()
+{
+	return m_errorLine;
+}
+
+int JsonPushParser::errorColumn()
+{
+	return m_errorColumn;
+}
+
+void JsonPushParser::setParseLFStyle(LFStyle style)
+{
+	m_parser.setParseLFStyle(style);
+}
+
+void JsonPushParser::setMaxDepth(size_t depth)
+{
+	m_parser.setMaxDepth(depth);
+}
+
+void JsonPushParser::setValidateUtf8(bool validate)
+{
+	m_parser.setValidateUtf8(validate);
+}
+
+// parse m_buffer as far as it goes, then drop what has been parsed
+int JsonPushParser::parse()
+{
+	JsonParser& p = m_parser;
+	const char* begin = m_buffer.c_str();
+	p.m_pJsonBegin = begin;
+	p.m_pJsonEnd = begin + m_buffer.size();
+	p.m_pJson = begin;
+	p.m_pCurLineHead = NULL;
+	p.m_bPastEnd = false;
+	int ret = eOk;
+	while (m_state != eStateDone)
+	{
+		const char* start = p.m_pJson;
+		int line = p.m_curLine;
+		const char* lineHead = p.m_pCurLineHead;
+		p.parseWhiteSpace();
+		char ch = p.peek();
+		bool more = p.m_pJson == p.m_pJsonEnd && !m_bFinishing; // the text may go on after this chunk
+		bool wait = more;
+		if (!more)
+		{
+			switch (m_state)
+			{
+			case eStateValue:
+				if (ch == '[' || ch == '{')
+				{
+					if (p.m_frames.size() == p.m_maxDepth)
+					{
+						ret = eNestingTooDeep;
+						break;
+					}
+					p.m_pJson++;
+					p.m_frames.push_back({ 0, ch == '{' });
+					m_state = ch == '{' ? eStateObjectFirst : eStateArrayFirst;
+				}
+				else if (!tokenComplete())
+				{
+					wait = true;
+				}
+				else if (ch == '\"')
+				{
+					std::string_view str;
+					ret = p.scanString(str);
+					if (ret == eOk)
+					{
+						p.storeString(p.m_stack.emplace_back(), str);
+						completeValue();
+					}
+				}
+				else
+				{
+					JsonValue scalar; // null, boolean or number
+					ret = p.parseValue(scalar);
+					if (ret == eOk)
+					{
+						p.m_stack.push_back(std::move(scalar));
+						completeValue();
+					}
+				}
+				break;
+			case eStateArrayFirst:
+				if (ch == ']')
+				{
+					p.m_pJson++;
+					closeContainer();
+				}
+				else
+					m_state = eStateValue;
+				break;
+			case eStateObjectFirst:
+				if (ch == '}')
+				{
+					p.m_pJson++;
+					closeContainer();
+				}
+				else
+					m_state = eStateKey;
+				break;
+			case eStateKey:
+				if (ch != '\"')
+				{
+					ret = eObjectMissKey;
+				}
+				else if (!tokenComplete())
+				{
+					wait = true;
+				}
+				else
+				{
+					std::string_view key;
+					ret = p.scanString(key);
+					if (ret == eOk)
+					{
+						p.storeString(p.m_stack.emplace_back(), key);
+						m_state = eStateColon;
+					}
+				}
+				break;
+			case eStateColon:
+				if (ch != ':')
+				{
+					ret = eObjectMissColon;
+				}
+				else
+				{
+					p.m_pJson++;
+					m_state = eStateValue;
+				}
+				break;
+			case eStateAfterValue:
+				{
+					bool object = p.m_frames.back().object;
+					if (ch == ',')
+					{
+						p.m_pJson++;
+						m_state = object ? eStateKey : eStateValue;
+					}
+					else if (ch == (object ? '}' : ']'))
+					{
+						p.m_pJson++;
+						closeContainer();
+					}
+					else if (object)
+					{
+						ret = eObjectMissCommaOrCurlyBracket;
+					}
+					else
+					{
+						p.skipUnexpected();
+						ret = eArrayMissCommaOrSquareBracket;
+					}
+				}
+				break;
+			case eStateEnd:
+				if (p.m_pJson != p.m_pJsonEnd)
+					ret = eRootNotSingular;
+				else
+					m_state = eStateDone;
+				break;
+			case eStateDone:
+				break;
+			}
+		}
+		if (ret != eOk)
+			break;
+		if (wait) // start again from the white space with the next chunk
+		{
+			p.m_pJson = start;
+			p.m_curLine = line;
+			p.m_pCurLineHead = lineHead;
+			break;
+		}
+	}
+
+	if (p.m_pCurLineHead)
+		m_lineHead = m_offset + (p.m_pCurLineHead - begin);
+	if (ret != eOk)
+	{
+		m_result = ret;
+		m_state = eStateDone;
+		m_errorLine = p.m_curLine;
+		m_errorColumn = int(m_offset + (p.m_pJson - begin) - m_lineHead + 1 + p.m_bPastEnd);
+		p.m_stack.clear();
+		p.m_frames.clear();
+	}
+	size_t parsed = p.m_pJson - begin;
+	m_buffer.erase(0, parsed);
+	m_offset += parsed;
+	p.m_pJson = p.m_pJsonBegin = p.m_pJsonEnd = p.m_pCurLineHead = NULL;
+	return ret;
+}
+
+static inline bool isTokenChar(char ch)
+{
+	return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '+' || ch == '-' || ch == '.';
+}
+
+// the string, number or literal at m_pJson can be parsed once the text shows its end
+bool JsonPushParser::tokenComplete()
+{
+	if (m_bFinishing)
+		return true;
+	const char* begin = m_buffer.c_str();
+	const char* token = m_parser.m_pJson;
+	const char* end = m_parser.m_pJsonEnd;
+	size_t tokenOffset = m_offset + (token - begin);
+	const char* from = m_scanned > tokenOffset ? begin + (m_scanned - m_offset) : token + (*token == '\"');
+	if (*token == '\"') // a quote after an even number of backslashes
+	{
+		while (true)
+		{
+			const char* quote = (const char*)memchr(from, '\"', end - from);
+			if (quote == NULL)
+				break;
+			const char* backslashes = quote;
+			while (backslashes[-1] == '\\') // stops at the opening quote at last
+				backslashes--;
+			if ((quote - backslashes) % 2 == 0)
+			{
+				m_scanned = 0;
+				return true;
+			}
+			from = quote + 1;
+		}
+	}
+	else
+	{
+		while (from < end && isTokenChar(*from))
+			from++;
+		if (from < end)
+		{
+			m_scanned = 0;
+			return true;
+		}
+	}
+	m_scanned = m_offset + (end - begin);
+	return false;
+}
+
+// the innermost array or object ends, its children move into it
+void JsonPushParser::closeContainer()
+{
+	JsonParser& p = m_parser;
+	JsonParser::Frame frame = p.m_frames.back();
+	p.m_frames.pop_back();
+	JsonValue container;
+	if (frame.object)
+		p.popObject(container, p.m_stack.size() - frame.count * 2);
+	else
+		p.popArray(container, p.m_stack.size() - frame.count);
+	p.m_stack.push_back(std::move(container));
+	completeValue();
+}
+
+void JsonPushParser::completeValue()
+{
+	JsonParser& p = m_parser;
+	if (p.m_frames.empty())
+	{
+		m_state = eStateEnd;
+	}
+	else
+	{
+		p.m_frames.back().count++;
+		m_state = eStateAfterValue;
+	}
+}
+
+}
@@ -0,0 +1,266 @@
+#ifndef _JSON_SIMD_H_
+#define _JSON_SIMD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// internal helpers for scanning the input a block at a time, not part of the public interface.
+/*
+AVX2: 32 bytes per block, SSE2: 16 bytes per block, otherwise a portable byte loop with the same interface.
+define MYJSON_NO_SIMD to force the portable path (useful for comparing results and speed).
+
+Blocks start at the scan position, not at an aligned address. A whole block is loaded directly, the last block
+that is cut short by the end of the input is copied into a zeroed local block first, so no byte outside the input
+is ever read. The mask from loadBounded tells which bytes of that block belong to the input.
+*/
+#if !defined(MYJSON_NO_SIMD) && defined(__AVX2__)
+#define MYJSON_SIMD_AVX2
+#include <immintrin.h>
+#elif !defined(MYJSON_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MYJSON_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace MyJson
+{
+namespace Simd
+{
+
+// one bit per byte of a block, bit i <-> byte i
+using Mask = uint32_t;
+
+#if defined(MYJSON_SIMD_AVX2)
+
+constexpr size_t kBlockSize = 32;
+constexpr Mask kFullMask = 0xFFFFFFFFu;
+
+struct Block
+{
+	__m256i v;
+};
+
+inline Block loadUnaligned(const char* p)
+{
+	return Block{ _mm256_loadu_si256((const __m256i*)p) };
+}
+
+inline Mask eqMask(const Block& b, char c)
+{
+	return (Mask)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b.v, _mm256_set1_epi8(c)));
+}
+
+// bytes whose unsigned value is less than c, c > 0
+inline Mask lessMask(const Block& b, unsigned char c)
+{
+	__m256i limit = _mm256_set1_epi8((char)(c - 1));
+	return (Mask)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(b.v, limit), b.v));
+}
+
+// bytes >= 0x80
+inline Mask highMask(const Block& b)
+{
+	return (Mask)_mm256_movemask_epi8(b.v);
+}
+
+#elif defined(MYJSON_SIMD_SSE2)
+
+constexpr size_t kBlockSize = 16;
+constexpr Mask kFullMask = 0xFFFFu;
+
+struct Block
+{
+	__m128i v;
+};
+
+inline Block loadUnaligned(const char* p)
+{
+	return Block{ _mm_loadu_si128((const __m128i*)p) };
+}
+
+inline Mask eqMask(const Block& b, char c)
+{
+	return (Mask)_mm_movemask_epi8(_mm_cmpeq_epi8(b.v, _mm_set1_epi8(c)));
+}
+
+inline Mask lessMask(const Block& b, unsigned char c)
+{
+	__m128i limit = _mm_set1_epi8((char)(c - 1));
+	return (Mask)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(b.v, limit), b.v));
+}
+
+inline Mask highMask(const Block& b)
+{
+	return (Mask)_mm_movemask_epi8(b.v);
+}
+
+#else
+
+constexpr size_t kBlockSize = 16;
+constexpr Mask kFullMask = 0xFFFFu;
+
+struct Block
+{
+	unsigned char v[kBlockSize];
+};
+
+inline Block loadUnaligned(const char* p)
+{
+	Block b;
+	for (size_t i = 0; i < kBlockSize; i++)
+		b.v[i] = (unsigned char)p[i];
+	return b;
+}
+
+inline Mask eqMask(const Block& b, char c)
+{
+	Mask m = 0;
+	for (size_t i = 0; i < kBlockSize; i++)
+		m |= Mask(b.v[i] == (unsigned char)c) << i;
+	return m;
+}
+
+inline Mask lessMask(const Block& b, unsigned char c)
+{
+	Mask m = 0;
+	for (size_t i = 0; i < kBlockSize; i++)
+		m |= Mask(b.v[i] < c) << i;
+	return m;
+}
+
+inline Mask highMask(const Block& b)
+{
+	Mask m = 0;
+	for (size_t i = 0; i < kBlockSize; i++)
+		m |= Mask(b.v[i] >= 0x80) << i;
+	return m;
+}
+
+#endif
+
+// mask of the bytes before offset in a block, offset < kBlockSize
+inline Mask beforeOffset(size_t offset)
+{
+	return (Mask(1) << offset) - 1;
+}
+
+// the block at p, p < end, a block cut short by end is copied and its bytes from end on read as 0
+// inRange gets the bytes that belong to the input
+inline Block loadBounded(const char* p, const char* end, Mask& inRange)
+{
+	size_t n = end - p;
+	if (n >= kBlockSize)
+	{
+		inRange = kFullMask;
+		return loadUnaligned(p);
+	}
+	char copy[kBlockSize] = {};
+	memcpy(copy, p, n);
+	inRange = beforeOffset(n);
+	return loadUnaligned(copy);
+}
+
+inline int popcount(Mask m)
+{
+#ifdef _MSC_VER
+	return (int)__popcnt(m);
+#else
+	return __builtin_popcount(m);
+#endif
+}
+
+// index of the lowest set bit, m != 0
+inline int lowestBit(Mask m)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, m);
+	return (int)index;
+#else
+	return __builtin_ctz(m);
+#endif
+}
+
+// index of the highest set bit, m != 0
+inline int highestBit(Mask m)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse(&index, m);
+	return (int)index;
+#else
+	return 31 - __builtin_clz(m);
+#endif
+}
+
+inline int popcount64(uint64_t m)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	return (int)__popcnt64(m);
+#elif defined(_MSC_VER)
+	return popcount((uint32_t)m) + popcount((uint32_t)(m >> 32));
+#else
+	return __builtin_popcountll(m);
+#endif
+}
+
+// 64 bytes as a unit, one bit per byte in a uint64_t
+constexpr size_t kChunkSize = 64;
+
+struct Chunk
+{
+	Block blocks[kChunkSize / kBlockSize];
+};
+
+// p must have kChunkSize readable bytes
+inline Chunk loadChunk(const char* p)
+{
+	Chunk c;
+	for (size_t i = 0; i < kChunkSize / kBlockSize; i++)
+		c.blocks[i] = loadUnaligned(p + i * kBlockSize);
+	return c;
+}
+
+// combine the block masks of func(block) into one chunk mask
+template<typename Func>
+inline uint64_t chunkMask(const Chunk& c, Func func)
+{
+	uint64_t m = 0;
+	for (size_t i = 0; i < kChunkSize / kBlockSize; i++)
+		m |= uint64_t(func(c.blocks[i])) << (i * kBlockSize);
+	return m;
+}
+
+// bit i of result = xor of bit 0 ~ i of m
+inline uint64_t prefixXor(uint64_t m)
+{
+	m ^= m << 1;
+	m ^= m << 2;
+	m ^= m << 4;
+	m ^= m << 8;
+	m ^= m << 16;
+	m ^= m << 32;
+	return m;
+}
+
+// index of the lowest set bit, m != 0
+inline int lowestBit64(uint64_t m)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, m);
+	return (int)index;
+#elif defined(_MSC_VER)
+	return (uint32_t)m ? lowestBit((uint32_t)m) : 32 + lowestBit((uint32_t)(m >> 32));
+#else
+	return __builtin_ctzll(m);
+#endif
+}
+
+}
+}
+#endif
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include "JsonThreadPool.h"
+
+namespace MyJson
+{
+
+ThreadPool::ThreadPool(unsigned int threadCount) :
+	m_pTask(nullptr),
+	m_generation(0),
+	m_running(0),
+	m_bStop(false)
+{
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int i = 1; i < threadCount; i++)
+		m_threads.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStop = true;
+	}
+	m_start.notify_all();
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+unsigned int ThreadPool::size() const
+{
+	return (unsigned int)m_threads.size() + 1;
+}
+
+void ThreadPool::run(const std::function<void(unsigned int)>& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pTask = &task;
+		m_generation++;
+		m_running = (unsigned int)m_threads.size();
+	}
+	m_start.notify_all();
+	task(0);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this]() { return m_running == 0; });
+	m_pTask = nullptr;
+}
+
+void ThreadPool::work(unsigned int worker)
+{
+	unsigned long long generation = 0;
+	while (true)
+	{
+		const std::function<void(unsigned int)>* task = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_start.wait(lock, [&]() { return m_bStop || m_generation != generation; });
+			if (m_bStop)
+				return;
+			generation = m_generation;
+			task = m_pTask;
+		}
+		(*task)(worker);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_running--;
+		}
+		m_done.notify_one();
+	}
+}
+
+}
@@ -0,0 +1,42 @@
+#ifndef _JSON_THREAD_POOL_H_
+#define _JSON_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// internal thread pool of the parallel parsers, not part of the public interface.
+namespace MyJson
+{
+
+// threads that wait for one task at a time and run it together with the caller
+class ThreadPool
+{
+public:
+	explicit ThreadPool(unsigned int threadCount); // threads running a task, the caller included, 0 for one per core
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned int size() const;
+	// task(worker) on every thread, worker 0 on the caller, returns when all of them have returned
+	void run(const std::function<void(unsigned int)>& task);
+
+private:
+	void work(unsigned int worker);
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_start;
+	std::condition_variable m_done;
+	const std::function<void(unsigned int)>* m_pTask;
+	unsigned long long m_generation; // counts the tasks, a thread runs each task once
+	unsigned int m_running;
+	bool m_bStop;
+};
+
+}
+#endif
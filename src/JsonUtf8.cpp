@@ -0,0 +1,309 @@
+#include <string.h>
+#include <stdint.h>
+#include "JsonUtf8.h"
+#include "JsonSimd.h"
+
+// the vector lookup needs SSSE3 or AVX2, a build for plain SSE2 picks it at run time by the CPU
+#if defined(MYJSON_SIMD_AVX2)
+#define MYJSON_UTF8_AVX2
+#elif defined(MYJSON_SIMD_SSE2)
+#define MYJSON_UTF8_SSSE3
+#define MYJSON_UTF8_AVX2
+#define MYJSON_UTF8_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace MyJson
+{
+namespace Utf8
+{
+
+// UTF-8
+/*
+有效的UTF-8（RFC 3629）：
+字节1			字节2		字节3		字节4
+00 ~ 7F
+C2 ~ DF			80 ~ BF
+E0				A0 ~ BF		80 ~ BF
+E1 ~ EC			80 ~ BF		80 ~ BF
+ED				80 ~ 9F		80 ~ BF		(不能编码代理码点U+D800 ~ U+DFFF)
+EE ~ EF			80 ~ BF		80 ~ BF
+F0				90 ~ BF		80 ~ BF		80 ~ BF
+F1 ~ F3			80 ~ BF		80 ~ BF		80 ~ BF
+F4				80 ~ 8F		80 ~ BF		80 ~ BF		(不超过U+10FFFF)
+其余都是错误：单独的后续字节、C0/C1与E0/F0的过长编码、编码的代理码点、超过U+10FFFF、F5 ~ FF，以及不完整的序列。
+
+向量化的查表校验（Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte"）：
+	- 每个字节与它前一个字节的组合只需要看三个4位：前一字节的高4位、低4位与本字节的高4位，
+	  各查一张16项的表（pshufb）得到可能出现的错误位，三者相与不为0就是错误，一次判断所有2字节内的错误。
+	- 3、4字节序列的第3、4个字节：前2（3）个字节是E0（F0）以上的lead时本字节必须是后续字节，
+	  用饱和减法得到这个要求，与上面"两个后续字节"的结果异或，不一致就是错误。
+	- 前一块的最后3个字节通过alignr拼到本块前面，序列可以跨块；最后一块不足时补0，未完成的序列在补的0处报错。
+	- 全是ASCII的块（且前一块也是ASCII）直接跳过。
+AVX2一次32字节，SSSE3一次16字节；没有SIMD时逐字节校验，ASCII一次8字节。
+默认的SSE2构建同时编译SSSE3与AVX2两个版本（GCC/Clang用target属性，MSVC不需要），第一次校验时按CPUID选择CPU支持的最宽的版本，
+两个版本共用JsonUtf8Lookup.h中的代码；-mavx2构建直接使用AVX2版本。
+查表只判断有没有错误，有错误时再逐字节找到第一个错误序列的位置（只在出错时发生）。
+*/
+
+// the first invalid sequence from p, which is at the start of a sequence
+static const char* findInvalidScalar(const char* p, const char* end)
+{
+	while (p < end)
+	{
+		uint64_t word;
+		if (end - p >= 8 && (memcpy(&word, p, 8), (word & 0x8080808080808080ull) == 0))
+		{
+			p += 8;
+			continue;
+		}
+		unsigned char ch = (unsigned char)*p;
+		if (ch < 0x80)
+		{
+			p++;
+			continue;
+		}
+		int length = 0;
+		unsigned char low = 0x80, high = 0xBF; // range of the second byte
+		if (ch >= 0xC2 && ch <= 0xDF)
+		{
+			length = 2;
+		}
+		else if (ch >= 0xE0 && ch <= 0xEF)
+		{
+			length = 3;
+			low = ch == 0xE0 ? 0xA0 : 0x80;
+			high = ch == 0xED ? 0x9F : 0xBF;
+		}
+		else if (ch >= 0xF0 && ch <= 0xF4)
+		{
+			length = 4;
+			low = ch == 0xF0 ? 0x90 : 0x80;
+			high = ch == 0xF4 ? 0x8F : 0xBF;
+		}
+		else
+		{
+			return p;
+		}
+		if (end - p < length || (unsigned char)p[1] < low || (unsigned char)p[1] > high)
+			return p;
+		for (int i = 2; i < length; i++)
+		{
+			if (((unsigned char)p[i] & 0xC0) != 0x80)
+				return p;
+		}
+		p += length;
+	}
+	return end;
+}
+
+#if defined(MYJSON_UTF8_AVX2)
+
+// error bits of a byte pair, each table gives the errors possible for one nibble
+constexpr uint8_t kTooShort = 1 << 0;		// a lead byte not followed by a continuation byte
+constexpr uint8_t kTooLong = 1 << 1;		// a continuation byte after an ASCII byte
+constexpr uint8_t kOverlong3 = 1 << 2;		// E0 80 ~ E0 9F
+constexpr uint8_t kTooLarge = 1 << 3;		// F4 90 and above
+constexpr uint8_t kSurrogate = 1 << 4;		// ED A0 ~ ED BF
+constexpr uint8_t kOverlong2 = 1 << 5;		// C0 and C1
+constexpr uint8_t kTooLarge1000 = 1 << 6;	// F5 ~ FF
+constexpr uint8_t kOverlong4 = 1 << 6;		// F0 80 ~ F0 8F
+constexpr uint8_t kTwoContinuations = 1 << 7;
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoContinuations;
+
+// high nibble of the previous byte
+alignas(16) static const uint8_t kByte1High[16] =
+{
+	kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,	// 0_______ ASCII
+	kTwoContinuations, kTwoContinuations, kTwoContinuations, kTwoContinuations,		// 10______ continuation
+	kTooShort | kOverlong2,										// 1100____
+	kTooShort,													// 1101____
+	kTooShort | kOverlong3 | kSurrogate,						// 1110____
+	kTooShort | kTooLarge | kTooLarge1000 | kOverlong4			// 1111____
+};
+
+// low nibble of the previous byte
+alignas(16) static const uint8_t kByte1Low[16] =
+{
+	kCarry | kOverlong3 | kOverlong2 | kOverlong4,				// ____0000
+	kCarry | kOverlong2,										// ____0001
+	kCarry,
+	kCarry,
+	kCarry | kTooLarge,											// ____0100
+	kCarry | kTooLarge | kTooLarge1000,
+	kCarry | kTooLarge | kTooLarge1000,
+	kCarry | kTooLarge | kTooLarge1000,
+	kCarry | kTooLarge | kTooLarge1000,
+	kCarry | kTooLarge | kTooLarge1000,
+	kCarry | kTooLarge | kTooLarge1000,
+	kCarry | kTooLarge | kTooLarge1000,
+	kCarry | kTooLarge | kTooLarge1000,
+	kCarry | kTooLarge | kTooLarge1000 | kSurrogate,			// ____1101
+	kCarry | kTooLarge | kTooLarge1000,
+	kCarry | kTooLarge | kTooLarge1000
+};
+
+// high nibble of the byte itself
+alignas(16) static const uint8_t kByte2High[16] =
+{
+	kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,	// 0_______ ASCII
+	kTooLong | kOverlong2 | kTwoContinuations | kOverlong3 | kTooLarge1000 | kOverlong4,	// 1000____
+	kTooLong | kOverlong2 | kTwoContinuations | kOverlong3 | kTooLarge,					// 1001____
+	kTooLong | kOverlong2 | kTwoContinuations | kSurrogate | kTooLarge,					// 101_____
+	kTooLong | kOverlong2 | kTwoContinuations | kSurrogate | kTooLarge,
+	kTooShort, kTooShort, kTooShort, kTooShort												// 11______ lead
+};
+
+#if defined(MYJSON_UTF8_SSSE3)
+#if defined(MYJSON_UTF8_DISPATCH) && defined(__clang__)
+#pragma clang attribute push(__attribute__((target("ssse3"))), apply_to = function)
+#elif defined(MYJSON_UTF8_DISPATCH) && defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+#endif
+
+namespace Ssse3
+{
+
+using Vector = __m128i;
+
+static inline Vector load(const char* p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline Vector splat(uint8_t c) { return _mm_set1_epi8((char)c); }
+static inline Vector table(const uint8_t* t) { return _mm_loadu_si128((const __m128i*)t); }
+static inline Vector lookup(Vector t, Vector index) { return _mm_shuffle_epi8(t, index); }
+static inline Vector high4(Vector v) { return _mm_and_si128(_mm_srli_epi16(v, 4), splat(0x0F)); }
+static inline Vector low4(Vector v) { return _mm_and_si128(v, splat(0x0F)); }
+static inline Vector bitAnd(Vector a, Vector b) { return _mm_and_si128(a, b); }
+static inline Vector bitOr(Vector a, Vector b) { return _mm_or_si128(a, b); }
+static inline Vector bitXor(Vector a, Vector b) { return _mm_xor_si128(a, b); }
+static inline Vector subSaturated(Vector a, Vector b) { return _mm_subs_epu8(a, b); }
+static inline bool isAscii(Vector v) { return _mm_movemask_epi8(v) == 0; }
+static inline bool isZero(Vector v) { return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF; }
+
+template<int n>
+static inline Vector prev(Vector input, Vector previous)
+{
+	return _mm_alignr_epi8(input, previous, 16 - n);
+}
+
+#include "JsonUtf8Lookup.h"
+
+}
+
+#if defined(MYJSON_UTF8_DISPATCH) && defined(__clang__)
+#pragma clang attribute pop
+#elif defined(MYJSON_UTF8_DISPATCH) && defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
+
+#if defined(MYJSON_UTF8_DISPATCH) && defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(MYJSON_UTF8_DISPATCH) && defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Avx2
+{
+
+using Vector = __m256i;
+
+static inline Vector load(const char* p) { return _mm256_loadu_si256((const __m256i*)p); }
+static inline Vector splat(uint8_t c) { return _mm256_set1_epi8((char)c); }
+static inline Vector table(const uint8_t* t) { return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)t)); }
+static inline Vector lookup(Vector t, Vector index) { return _mm256_shuffle_epi8(t, index); }
+static inline Vector high4(Vector v) { return _mm256_and_si256(_mm256_srli_epi16(v, 4), splat(0x0F)); }
+static inline Vector low4(Vector v) { return _mm256_and_si256(v, splat(0x0F)); }
+static inline Vector bitAnd(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+static inline Vector bitOr(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+static inline Vector bitXor(Vector a, Vector b) { return _mm256_xor_si256(a, b); }
+static inline Vector subSaturated(Vector a, Vector b) { return _mm256_subs_epu8(a, b); }
+static inline bool isAscii(Vector v) { return _mm256_movemask_epi8(v) == 0; }
+static inline bool isZero(Vector v) { return _mm256_testz_si256(v, v) != 0; }
+
+// input shifted by n bytes, with the last bytes of previous in front
+template<int n>
+static inline Vector prev(Vector input, Vector previous)
+{
+	return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - n);
+}
+
+#include "JsonUtf8Lookup.h"
+
+}
+
+#if defined(MYJSON_UTF8_DISPATCH) && defined(__clang__)
+#pragma clang attribute pop
+#elif defined(MYJSON_UTF8_DISPATCH) && defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
+
+#if defined(MYJSON_UTF8_DISPATCH)
+
+// AVX2 also needs the OS to save the YMM registers
+static bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)); // OSXSAVE and AVX
+	if (!avx || (_xgetbv(0) & 6) != 6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool cpuHasSsse3()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 9)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+using FindInvalid = const char* (*)(const char* p, const char* end);
+
+static FindInvalid selectFindInvalid()
+{
+	if (cpuHasAvx2())
+		return Avx2::findInvalid;
+	if (cpuHasSsse3())
+		return Ssse3::findInvalid;
+	return findInvalidScalar;
+}
+
+const char* findInvalid(const char* p, const char* end)
+{
+	static const FindInvalid find = selectFindInvalid(); // chosen once, the first parse on any thread
+	return find(p, end);
+}
+
+#elif defined(MYJSON_UTF8_AVX2)
+
+const char* findInvalid(const char* p, const char* end)
+{
+	return Avx2::findInvalid(p, end);
+}
+
+#else
+
+const char* findInvalid(const char* p, const char* end)
+{
+	return findInvalidScalar(p, end);
+}
+
+#endif
+
+}
+}
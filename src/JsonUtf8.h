@@ -0,0 +1,16 @@
+#ifndef _JSON_UTF8_H_
+#define _JSON_UTF8_H_
+
+// internal UTF-8 validation of string contents, not part of the public interface.
+namespace MyJson
+{
+namespace Utf8
+{
+
+// first byte of the first invalid or incomplete sequence in [p, end), end if all of it is valid UTF-8
+// p must be at the start of a sequence; the bytes outside [p, end) are never read.
+const char* findInvalid(const char* p, const char* end);
+
+}
+}
+#endif
@@ -0,0 +1,41 @@
+// internal, the vector UTF-8 lookup of JsonUtf8.cpp for one instruction set.
+// included once per instruction set inside its namespace, after the Vector type and its helpers; no include guard.
+
+constexpr size_t kVectorSize = sizeof(Vector);
+
+// nonzero bytes where input, after the bytes of previous, is not valid
+static inline Vector check(Vector input, Vector previous)
+{
+	Vector prev1 = prev<1>(input, previous);
+	Vector special = bitAnd(bitAnd(lookup(table(kByte1High), high4(prev1)), lookup(table(kByte1Low), low4(prev1))),
+		lookup(table(kByte2High), high4(input)));
+	// the third and fourth bytes of 3 and 4 byte sequences must be continuation bytes
+	Vector third = subSaturated(prev<2>(input, previous), splat(0xE0 - 0x80));
+	Vector fourth = subSaturated(prev<3>(input, previous), splat(0xF0 - 0x80));
+	return bitXor(bitAnd(bitOr(third, fourth), splat(0x80)), special);
+}
+
+static const char* findInvalid(const char* p, const char* end)
+{
+	const char* begin = p;
+	Vector previous = splat(0);
+	bool previousAscii = true;
+	for (; end - p >= (ptrdiff_t)kVectorSize; p += kVectorSize)
+	{
+		Vector input = load(p);
+		bool ascii = isAscii(input);
+		if (!(ascii && previousAscii) && !isZero(check(input, previous)))
+			return findInvalidScalar(begin, end);
+		previous = input;
+		previousAscii = ascii;
+	}
+	if (previousAscii) // the rest starts a new sequence
+		return findInvalidScalar(p, end);
+	// the rest padded with zeros, a sequence left open ends at the padding
+	alignas(32) char rest[kVectorSize] = {};
+	memcpy(rest, p, end - p);
+	if (!isZero(check(load(rest), previous)))
+		return findInvalidScalar(begin, end);
+	return end;
+}
+
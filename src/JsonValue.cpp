@@ -1,79 +1,108 @@
 #include <cassert> // for assert
+#include <string.h>
+#include <utility>
 #include "JsonValue.h"
 
 namespace MyJson
 {
 
+static_assert(sizeof(void*) != 8 || sizeof(JsonValue) == 16, "JsonValue is a 16 bytes node on 64 bit platforms");
+
 const JsonValue JsonValue::sNullValue;
 
+// out-of-line storage of arrays and objects comes from their own memory resource, and goes back to it
+template<typename T, typename... Args>
+static T* newStorage(std::pmr::memory_resource* resource, Args&&... args)
+{
+	return std::pmr::polymorphic_allocator<std::byte>(resource).new_object<T>(std::forward<Args>(args)...);
+}
+
+template<typename T>
+static void deleteStorage(std::pmr::memory_resource* resource, T* p)
+{
+	std::pmr::polymorphic_allocator<std::byte>(resource).delete_object(p);
+}
+
 JsonValue::JsonValue() :
-	m_valueType(eNull), 
-	m_var() {}
+	m_payload{ 0.0 },
+	m_meta(eNull) {}
 
 JsonValue::JsonValue(ValueType t) :
-	m_valueType(t),
-	m_var()
+	JsonValue(t, std::pmr::get_default_resource()) {}
+
+JsonValue::JsonValue(ValueType t, std::pmr::memory_resource* resource) :
+	m_payload{ 0.0 },
+	m_meta(eNull)
 	{
-		switch (t)
-		{
-		case eString:
-			m_var = StringType();
-			break;
-		case eArray:
-			m_var = ArrayType();
-			break;
-		case eObject:
-			m_var = ObjectType();
-			break;
-		}
+		init(t, resource);
 	}
 
 JsonValue::JsonValue(bool b) :
-	m_valueType(b ? eTrue : eFalse),
-	m_var() {}
+	m_payload{ 0.0 },
+	m_meta(b ? eTrue : eFalse) {}
 
-JsonValue::JsonValue(double val) : 
-	m_valueType(eNumber), 
-	m_var(val) {}
+JsonValue::JsonValue(double val) :
+	m_payload{ val },
+	m_meta(eNumber) {}
 
 JsonValue::JsonValue(int val) :
-	m_valueType(eNumber),
-	m_var(double(val)) {}
+	JsonValue(int64_t(val)) {}
+
+JsonValue::JsonValue(int64_t val) :
+	m_payload{ 0.0 },
+	m_meta(eInt64)
+	{
+		m_payload.int64 = val;
+	}
+
+JsonValue::JsonValue(uint64_t val) :
+	m_payload{ 0.0 },
+	m_meta(eUint64)
+	{
+		m_payload.uint64 = val;
+	}
 
 JsonValue::JsonValue(const std::string& str) :
-	m_valueType(eString),
-	m_var(str){}
+	JsonValue(str.data(), str.size()) {}
 
 JsonValue::JsonValue(const char* str) :
-	m_valueType(eString), 
-	m_var(str) {}
+	JsonValue(str, strlen(str)) {}
 
 JsonValue::JsonValue(const char* begin, const char* end) :
-	m_valueType(eString), 
-	m_var(StringType(begin, end)) {}
+	JsonValue(begin, size_t(end - begin)) {}
 
 JsonValue::JsonValue(const char* str, size_t len) :
-	m_valueType(eString),
-	m_var(StringType(str, str + len)) {}
+	m_payload{ 0.0 },
+	m_meta(eString)
+	{
+		m_payload.string = new StringType(str, len);
+	}
 
-JsonValue::JsonValue(const JsonValue& value)
+JsonValue::JsonValue(const JsonValue& value) :
+	m_payload{ 0.0 },
+	m_meta(eNull)
 {
 	copyFrom(value);
 }
 
-JsonValue::JsonValue(JsonValue&& value)
+JsonValue::JsonValue(JsonValue&& value) noexcept :
+	m_payload(value.m_payload),
+	m_meta(value.m_meta)
 {
-	moveFrom(value);
+	value.m_meta = eNull;
 }
 
-JsonValue::~JsonValue() {}
+JsonValue::~JsonValue()
+{
+	release();
+}
 
 JsonValue& JsonValue::operator=(const JsonValue& value)
 {
 	copyFrom(value);
 	return *this;
 }
-JsonValue& JsonValue::operator=(JsonValue&& value)
+JsonValue& JsonValue::operator=(JsonValue&& value) noexcept
 {
 	moveFrom(value);
 	return *this;
@@ -81,19 +110,45 @@ JsonValue& JsonValue::operator=(JsonValue&& value)
 
 bool JsonValue::operator==(const JsonValue& value) const
 {
-	if (m_valueType == value.m_valueType)
+	// numbers of different kinds compare by value
+	if (isNumber() && value.isNumber() && type() != value.type())
+	{
+		if (type() == eNumber || value.type() == eNumber)
+			return getNumber() == value.getNumber();
+		return isUint64() && value.isUint64() && getUint64() == value.getUint64();
+	}
+	if (type() == value.type())
 	{
-		switch (m_valueType)
+		switch (type())
 		{
 		case eNull:
 		case eTrue:
 		case eFalse:
 			return true;
+		case eString: // owned and borrowed strings compare by content
+			return getStringView() == value.getStringView();
+		case eObject: // keys compare by content too, members may be in any order
+			{
+				const ObjectType& object1 = *m_payload.object;
+				const ObjectType& object2 = *value.m_payload.object;
+				if (object1.size() != object2.size())
+					return false;
+				for (const Member& member : object1)
+				{
+					const Member* other = object2.find(member.key.getStringView());
+					if (!other || other->value != member.value)
+						return false;
+				}
+				return true;
+			}
 		case eNumber:
-		case eString:
+			return m_payload.number == value.m_payload.number;
 		case eArray:
-		case eObject:
-			return m_var == value.m_var;
+			return *m_payload.array == *value.m_payload.array;
+		case eInt64:
+			return m_payload.int64 == value.m_payload.int64;
+		case eUint64:
+			return m_payload.uint64 == value.m_payload.uint64;
 		}
 	}
 	return false;
@@ -104,151 +159,287 @@ bool JsonValue::operator!=(const JsonValue& value) const
 	return !(*this == value);
 }
 
-void JsonValue::copyFrom(const JsonValue& value)
+void JsonValue::copyFrom(const JsonValue& value) // a deep copy, arrays and objects of the copy use the default resource
 {
-	setNull();
-	m_valueType = value.type();
-	m_var = value.m_var;
+	if (this == &value)
+		return;
+	Payload payload = value.m_payload;
+	uint64_t meta = value.m_meta;
+	switch (value.type())
+	{
+	case eString:
+		if (!value.isBorrowedString())
+			payload.string = new StringType(*value.m_payload.string);
+		break;
+	case eArray:
+		payload.array = newStorage<ArrayType>(std::pmr::get_default_resource(), *value.m_payload.array);
+		break;
+	case eObject:
+		payload.object = newStorage<ObjectType>(std::pmr::get_default_resource(), *value.m_payload.object, std::pmr::get_default_resource());
+		break;
+	default: // the scalars are in the payload
+		break;
+	}
+	// value may be inside this, release after the copy
+	release();
+	m_payload = payload;
+	m_meta = meta;
+}
+
+void JsonValue::moveFrom(JsonValue& value) noexcept // arrays and objects keep their memory resource
+{
+	if (this == &value)
+		return;
+	// value may be inside this, take it over before releasing
+	Payload payload = value.m_payload;
+	uint64_t meta = value.m_meta;
+	value.m_meta = eNull;
+	release();
+	m_payload = payload;
+	m_meta = meta;
 }
 
-void JsonValue::moveFrom(JsonValue& value)
+void JsonValue::release() // free the out-of-line storage, become null
 {
-	setNull();
-	m_valueType = value.type();
-	m_var = std::move(value.m_var);
+	switch (type())
+	{
+	case eString:
+		if (!isBorrowedString())
+			delete m_payload.string;
+		break;
+	case eArray:
+		deleteStorage(m_payload.array->get_allocator().resource(), m_payload.array);
+		break;
+	case eObject:
+		deleteStorage(m_payload.object->resource(), m_payload.object);
+		break;
+	default: // nothing out of line
+		break;
+	}
+	m_meta = eNull;
 }
 
-void JsonValue::setType(ValueType t) 
+void JsonValue::init(ValueType t, std::pmr::memory_resource* resource) // from null to an empty value of type t
 {
-	m_valueType = t;
+	assert(type() == eNull);
+	m_payload.uint64 = 0;
 	switch (t)
 	{
 	case eString:
-		m_var = StringType();
+		m_payload.string = new StringType();
 		break;
 	case eArray:
-		m_var = ArrayType();
+		m_payload.array = newStorage<ArrayType>(resource);
 		break;
 	case eObject:
-		m_var = ObjectType();
+		m_payload.object = newStorage<ObjectType>(resource, resource);
+		break;
+	default: // a scalar starts at 0
 		break;
 	}
+	m_meta = t;
 }
+
+void JsonValue::setType(ValueType t)
+{
+	setType(t, std::pmr::get_default_resource());
+}
+
+void JsonValue::setType(ValueType t, std::pmr::memory_resource* resource)
+{
+	release();
+	init(t, resource);
+}
+
 ValueType JsonValue::type() const
-{ 
-	return m_valueType;
+{
+	return ValueType(m_meta & kTypeMask);
 }
 
 // null
 bool JsonValue::isNull() const
 {
-	return m_valueType == eNull;
+	return type() == eNull;
 }
 void JsonValue::setNull()
 {
-	m_valueType = eNull;
-	m_var = 0.0;
+	release();
 }
 
 // boolean
 bool JsonValue::isBool() const
 {
-	return m_valueType == eTrue || m_valueType == eFalse;
+	return type() == eTrue || type() == eFalse;
 }
 
-bool JsonValue::isTrue() const 
-{ 
-	return m_valueType == eTrue;
+bool JsonValue::isTrue() const
+{
+	return type() == eTrue;
 }
 
-bool JsonValue::isFalse() const 
-{ 
-	return m_valueType == eFalse;
+bool JsonValue::isFalse() const
+{
+	return type() == eFalse;
 }
 
 void JsonValue::setBool(bool b)
 {
-	assert(m_valueType == eNull || m_valueType == eTrue || m_valueType == eFalse);
-	m_valueType = (b ? eTrue : eFalse);
+	assert(type() == eNull || type() == eTrue || type() == eFalse);
+	release(); // a string, array or object set by mistake would leak its storage otherwise
+	m_meta = (b ? eTrue : eFalse);
 }
 
 bool JsonValue::getBool() const
 {
-	assert(m_valueType == eTrue || m_valueType == eFalse);
-	return m_valueType == eTrue;
+	assert(type() == eTrue || type() == eFalse);
+	return type() == eTrue;
 }
 
 // number
 bool JsonValue::isNumber() const
 {
-	return m_valueType == eNumber;
+	return type() == eNumber || type() == eInt64 || type() == eUint64;
 }
 
-double JsonValue::getNumber() const
+double JsonValue::getNumber() const // integers are converted to double
 {
-	assert(m_valueType == eNumber);
-	assert(m_var.index() == 0);
-	return std::get<double>(m_var);
+	assert(isNumber());
+	if (type() == eInt64)
+		return double(m_payload.int64);
+	if (type() == eUint64)
+		return double(m_payload.uint64);
+	return m_payload.number;
 }
 
 void JsonValue::setNumber(double val)
 {
-	assert(m_valueType == eNull || m_valueType == eNumber);
-	m_valueType = eNumber;
-	m_var = val;
+	assert(type() == eNull || isNumber());
+	release();
+	m_meta = eNumber;
+	m_payload.number = val;
+}
+
+bool JsonValue::isInt64() const // integer representable by int64
+{
+	return type() == eInt64 || (type() == eUint64 && m_payload.uint64 <= uint64_t(INT64_MAX));
+}
+
+bool JsonValue::isUint64() const // integer representable by uint64
+{
+	return type() == eUint64 || (type() == eInt64 && m_payload.int64 >= 0);
+}
+
+int64_t JsonValue::getInt64() const
+{
+	assert(isInt64());
+	if (type() == eUint64)
+		return int64_t(m_payload.uint64);
+	return m_payload.int64;
+}
+
+uint64_t JsonValue::getUint64() const
+{
+	assert(isUint64());
+	if (type() == eInt64)
+		return uint64_t(m_payload.int64);
+	return m_payload.uint64;
+}
+
+void JsonValue::setInt64(int64_t val)
+{
+	assert(type() == eNull || isNumber());
+	release();
+	m_meta = eInt64;
+	m_payload.int64 = val;
+}
+
+void JsonValue::setUint64(uint64_t val)
+{
+	assert(type() == eNull || isNumber());
+	release();
+	m_meta = eUint64;
+	m_payload.uint64 = val;
 }
 
 // string
 bool JsonValue::isString() const
 {
-	return m_valueType == eString;
+	return type() == eString;
+}
+
+// a copy for both owned and borrowed strings, getStringView reads either without copying.
+// a const value is never changed, so several threads can read it at once.
+std::string JsonValue::getString() const
+{
+	return std::string(getStringView());
+}
+
+std::string_view JsonValue::getStringView() const
+{
+	assert(type() == eString);
+	if (isBorrowedString())
+		return std::string_view(m_payload.view, size_t(m_meta >> kLengthShift));
+	return *m_payload.string;
+}
+
+bool JsonValue::isBorrowedString() const
+{
+	return (m_meta & (kTypeMask | kBorrowed)) == (eString | kBorrowed);
 }
 
-const std::string& JsonValue::getString() const
+void JsonValue::setStringView(std::string_view str) // refer to str without copying, str must outlive the value and its copies
 {
-	assert(m_valueType == eString);
-	assert(m_var.index() == 1);
-	return std::get<StringType>(m_var);
+	assert(type() == eNull || type() == eString);
+	release();
+	m_payload.view = str.data();
+	m_meta = eString | kBorrowed | (uint64_t(str.size()) << kLengthShift);
 }
 
 void JsonValue::setString(const char* str, size_t len) // str can include \0
 {
-	setString(str, str + len);
+	setString(std::string(str, len));
 }
 
 void JsonValue::setString(const char* begin, const char* end)
 {
-	assert(m_valueType == eNull || m_valueType == eString);
-	m_valueType = eString;
-	m_var = std::string(begin, end);
+	setString(std::string(begin, end));
 }
 
 void JsonValue::setString(const std::string& str)
 {
-	assert(m_valueType == eNull || m_valueType == eString);
-	m_valueType = eString;
-	m_var = str;
+	setString(std::string(str));
+}
+
+void JsonValue::setString(std::string&& str) // take over a rvalue
+{
+	assert(type() == eNull || type() == eString);
+	if (type() == eString && !isBorrowedString())
+	{
+		*m_payload.string = std::move(str);
+		return;
+	}
+	release();
+	m_payload.string = new StringType(std::move(str));
+	m_meta = eString;
 }
 
 // array
 bool JsonValue::isArray() const
 {
-	return m_valueType == eArray;
+	return type() == eArray;
 }
 
 const JsonValue& JsonValue::get(size_t index) const // get copy of array element
 {
-	assert(m_valueType == eArray);
-	assert(m_var.index() == 2);
-	assert(index >= 0 && index < std::get<ArrayType>(m_var).size());
-	return std::get<ArrayType>(m_var)[index];
+	assert(type() == eArray);
+	assert(index >= 0 && index < m_payload.array->size());
+	return (*m_payload.array)[index];
 }
 
 void JsonValue::resize(size_t newSize) // resize array
 {
-	assert(m_valueType == eArray && newSize >= 0);
-	assert(m_var.index() == 2);
-	std::get<ArrayType>(m_var).resize(newSize);
+	assert(type() == eArray && newSize >= 0);
+	m_payload.array->resize(newSize);
 }
 
 void JsonValue::append(const JsonValue& value) // append a new value to array
@@ -258,14 +449,12 @@ void JsonValue::append(const JsonValue& value) // append a new value to array
 
 void JsonValue::append(JsonValue&& value) // append a rvalue
 {
-	assert(m_valueType == eNull || m_valueType == eArray);
-	if (m_valueType == eNull)
+	assert(type() == eNull || type() == eArray);
+	if (type() == eNull)
 	{
-		m_var = ArrayType{};
+		init(eArray, std::pmr::get_default_resource());
 	}
-	m_valueType = eArray;
-	assert(m_var.index() == 2);
-	std::get<ArrayType>(m_var).emplace_back(std::move(value));
+	m_payload.array->emplace_back(std::move(value));
 }
 
 bool JsonValue::insert(size_t index, const JsonValue& value) // insert a value to index
@@ -275,168 +464,358 @@ bool JsonValue::insert(size_t index, const JsonValue& value) // insert a value t
 
 bool JsonValue::insert(size_t index, JsonValue&& value) // insert a rvalue to index
 {
-	assert(m_var.index() == 2);
-	if (m_valueType != eArray || !(index >= 0 && index <= std::get<ArrayType>(m_var).size()))
+	if (type() != eArray || !(index >= 0 && index <= m_payload.array->size()))
 		return false;
-	std::get<ArrayType>(m_var).emplace(std::get<ArrayType>(m_var).begin() + index, std::move(value));
+	m_payload.array->emplace(m_payload.array->begin() + index, std::move(value));
 	return true;
 }
 
 bool JsonValue::removeAt(size_t index, JsonValue& removed) // remove value of index, get removed value
 {
-	assert(m_var.index() == 2);
-	if (m_valueType != eArray || !(index >= 0 && index < std::get<ArrayType>(m_var).size()))
+	if (type() != eArray || !(index >= 0 && index < m_payload.array->size()))
 		return false;
-	removed = std::move(std::get<ArrayType>(m_var)[index]);
-	std::get<ArrayType>(m_var).erase(std::get<ArrayType>(m_var).begin() + index);
+	removed = std::move((*m_payload.array)[index]);
+	m_payload.array->erase(m_payload.array->begin() + index);
 	return true;
 }
 
 bool JsonValue::removeAt(size_t index) // just remove value of index
 {
-	assert(m_var.index() == 2);
-	if (m_valueType != eArray || !(index >= 0 && index < std::get<ArrayType>(m_var).size()))
+	if (type() != eArray || !(index >= 0 && index < m_payload.array->size()))
 		return false;
-	std::get<ArrayType>(m_var).erase(std::get<ArrayType>(m_var).begin() + index);
+	m_payload.array->erase(m_payload.array->begin() + index);
 	return true;
 }
 
 JsonValue& JsonValue::operator[](size_t index) // get reference of array element
 {
-	assert(m_valueType == eArray);
-	assert(m_var.index() == 2);
-	assert(index >= 0 && index < std::get<ArrayType>(m_var).size());
-	return std::get<ArrayType>(m_var)[index];
+	assert(type() == eArray);
+	assert(index >= 0 && index < m_payload.array->size());
+	return (*m_payload.array)[index];
 }
 
 const JsonValue& JsonValue::operator[](size_t index) const // get const reference of array element
 {
-	assert(m_valueType == eArray);
-	assert(m_var.index() == 2);
-	assert(index >= 0 && index < std::get<ArrayType>(m_var).size());
-	return std::get<ArrayType>(m_var)[index];
+	assert(type() == eArray);
+	assert(index >= 0 && index < m_payload.array->size());
+	return (*m_payload.array)[index];
 }
 
 // object
 bool JsonValue::isObject() const
 {
-	return m_valueType == eObject;
+	return type() == eObject;
 }
 
-bool JsonValue::containsKey(const std::string& key) const // if these is a key in object
+bool JsonValue::containsKey(std::string_view key) const // if these is a key in object
 {
-	assert(m_valueType == eObject);
-	assert(m_var.index() == 3);
-	return std::get<ObjectType>(m_var).find(key) != std::get<ObjectType>(m_var).end();
+	assert(type() == eObject);
+	return m_payload.object->find(key) != nullptr;
 }
 
-std::vector<std::string> JsonValue::getKeys() const // get all keys
+std::vector<std::string> JsonValue::getKeys() const // get all keys, in insertion order
 {
-	assert(m_valueType == eObject);
-	assert(m_var.index() == 3);
+	assert(type() == eObject);
 	std::vector<std::string> keys;
-	for (auto iter = std::get<ObjectType>(m_var).begin(); iter != std::get<ObjectType>(m_var).end(); iter++)
-		keys.push_back(iter->first);
-	return std::move(keys);
+	for (const Member& member : *m_payload.object)
+		keys.emplace_back(member.key.getStringView());
+	return keys;
 }
 
-const JsonValue& JsonValue::get(const std::string& key) const // get const reference of value of key
+std::vector<std::string_view> JsonValue::getKeyViews() const // get all keys without copying them, valid until the object changes
 {
-	assert(m_valueType == eObject);
-	assert(m_var.index() == 3);
-	auto iter = std::get<ObjectType>(m_var).find(key);
-	if (iter == std::get<ObjectType>(m_var).end())
+	assert(type() == eObject);
+	std::vector<std::string_view> keys;
+	for (const Member& member : *m_payload.object)
+		keys.push_back(member.key.getStringView());
+	return keys;
+}
+
+const JsonValue& JsonValue::get(std::string_view key) const // get const reference of value of key
+{
+	assert(type() == eObject);
+	const Member* member = m_payload.object->find(key);
+	if (member == nullptr)
 		return sNullValue;
 	else
-		return iter->second;
+		return member->value;
 }
 
 void JsonValue::appendKey(const std::string& key, const JsonValue& value) // append a value to object for key
 {
-	assert(m_valueType == eObject || m_valueType == eNull);
-	if (m_valueType == eNull)
+	appendKey(key, JsonValue(value));
+}
+
+void JsonValue::appendKey(const std::string& key, JsonValue&& value) // append a rvalue to object for key
+{
+	operator[](key) = std::move(value);
+}
+
+void JsonValue::appendKeyView(std::string_view key, JsonValue&& value) // key is not copied, it must outlive the value like setStringView
+{
+	assert(type() == eObject || type() == eNull);
+	if (type() == eNull)
+	{
+		init(eObject, std::pmr::get_default_resource());
+	}
+	Member* member = m_payload.object->find(key);
+	if (member == nullptr)
+	{
+		JsonValue keyValue;
+		keyValue.setStringView(key);
+		m_payload.object->add(std::move(keyValue), std::move(value));
+	}
+	else
+	{
+		member->value = std::move(value);
+	}
+}
+
+void JsonValue::appendMember(JsonValue&& key, JsonValue&& value) // take over a string key as it is, owned or borrowed
+{
+	assert(key.isString());
+	assert(type() == eObject || type() == eNull);
+	if (type() == eNull)
 	{
-		m_var = ObjectType();
+		init(eObject, std::pmr::get_default_resource());
 	}
-	m_valueType = eObject;
-	assert(m_var.index() == 3);
-	std::get<ObjectType>(m_var)[key] = value;
+	Member* member = m_payload.object->find(key.getStringView());
+	if (member == nullptr)
+		m_payload.object->add(std::move(key), std::move(value));
+	else
+		member->value = std::move(value);
 }
 
 bool JsonValue::removeKey(const std::string& key, JsonValue& removed) // erase value of key, get removed vlaue
 {
-	assert(m_var.index() == 3);
-	if (m_valueType != eObject || !containsKey(key))
+	if (type() != eObject)
+		return false;
+	Member* member = m_payload.object->find(key);
+	if (member == nullptr)
 		return false;
-	removed = std::move(std::get<ObjectType>(m_var)[key]);
-	std::get<ObjectType>(m_var).erase(key);
+	removed = std::move(member->value);
+	m_payload.object->erase(member);
 	return true;
 }
 
 bool JsonValue::removeKey(const std::string& key) // just remove value of key
 {
-	assert(m_var.index() == 3);
-	if (m_valueType != eObject || !containsKey(key))
+	if (type() != eObject)
+		return false;
+	Member* member = m_payload.object->find(key);
+	if (member == nullptr)
 		return false;
-	std::get<ObjectType>(m_var).erase(key);
+	m_payload.object->erase(member);
 	return true;
 }
 
 JsonValue& JsonValue::operator[](const std::string& key) // get reference of value of key
 {
-	assert(m_valueType == eObject || m_valueType == eNull);
-	if (m_valueType == eNull)
+	assert(type() == eObject || type() == eNull);
+	if (type() == eNull)
 	{
-		m_var = ObjectType();
+		init(eObject, std::pmr::get_default_resource());
 	}
-	m_valueType = eObject;
-	assert(m_var.index() == 3);
-	return std::get<ObjectType>(m_var)[key];
+	Member* member = m_payload.object->find(key);
+	if (member == nullptr)
+		return m_payload.object->add(JsonValue(key), JsonValue());
+	return member->value;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const // get const reference of value of key, null if absent
+{
+	return get(key);
 }
 
 // array & object in common
 size_t JsonValue::size() const // object & array size
 {
-	assert(m_valueType == eArray || m_valueType == eObject);
-	if (m_valueType == eArray)
-	{
-		assert(m_var.index() == 2);
-		return std::get<ArrayType>(m_var).size();
-	}
+	assert(type() == eArray || type() == eObject);
+	if (type() == eArray)
+		return m_payload.array->size();
 	else
-	{
-		assert(m_var.index() == 3);
-		return std::get<ObjectType>(m_var).size();
-	}
+		return m_payload.object->size();
 }
 
 void JsonValue::clear() // clear all elements
 {
-	assert(m_valueType == eArray || m_valueType == eObject);
-	assert(m_var.index() == 2 || m_var.index() == 3);
-	if (m_var.index() == 2)
-	{
-		std::get<ArrayType>(m_var).clear();
-	}
+	assert(type() == eArray || type() == eObject);
+	if (type() == eArray)
+		m_payload.array->clear();
 	else
+		m_payload.object->clear();
+}
+
+void JsonValue::reserve(size_t newCapacity) // reserve room for elements or members
+{
+	assert(type() == eArray || type() == eObject);
+	if (type() == eArray)
+		m_payload.array->reserve(newCapacity);
+	else
+		m_payload.object->reserve(newCapacity);
+}
+
+bool JsonValue::empty() const // is array or object empty
+{
+	assert(type() == eArray || type() == eObject);
+	if (type() == eArray)
+		return m_payload.array->empty();
+	else
+		return m_payload.object->empty();
+}
+
+// object storage
+/*
+成员按插入顺序连续存放在一个vector中，遍历与生成时保持原始的key顺序。
+查找：成员数不超过kObjectScanLimit时线性扫描（大多数object都很小，比哈希更快）；
+超过后使用开放寻址的哈希索引，槽中存放成员位置+1，0表示空槽。
+索引在修改object时维护，不在查找时建立，所以const的查找不写任何数据，多个线程可以同时读取：
+	- 添加成员使成员数超过kObjectScanLimit时建立索引，之后添加成员同时更新索引，装载因子超过1/2时重新建立
+	- 删除成员后成员数仍超过kObjectScanLimit时重新建立，否则丢弃
+*/
+static constexpr size_t kObjectScanLimit = 16;
+
+JsonValue::ObjectType::ObjectType(std::pmr::memory_resource* resource) :
+	m_members(resource),
+	m_index(resource) {}
+
+JsonValue::ObjectType::ObjectType(const ObjectType& other, std::pmr::memory_resource* resource) :
+	m_members(other.m_members, resource),
+	m_index(other.m_index, resource) {}
+
+std::pmr::memory_resource* JsonValue::ObjectType::resource() const
+{
+	return m_members.get_allocator().resource();
+}
+
+size_t JsonValue::ObjectType::size() const
+{
+	return m_members.size();
+}
+
+bool JsonValue::ObjectType::empty() const
+{
+	return m_members.empty();
+}
+
+void JsonValue::ObjectType::clear()
+{
+	m_members.clear();
+	m_index.clear();
+}
+
+void JsonValue::ObjectType::reserve(size_t newCapacity)
+{
+	m_members.reserve(newCapacity);
+}
+
+const JsonValue::Member* JsonValue::ObjectType::begin() const
+{
+	return m_members.data();
+}
+
+const JsonValue::Member* JsonValue::ObjectType::end() const
+{
+	return m_members.data() + m_members.size();
+}
+
+JsonValue::Member* JsonValue::ObjectType::begin()
+{
+	return m_members.data();
+}
+
+JsonValue::Member* JsonValue::ObjectType::end()
+{
+	return m_members.data() + m_members.size();
+}
+
+JsonValue::Member* JsonValue::ObjectType::find(std::string_view key)
+{
+	return const_cast<Member*>(std::as_const(*this).find(key));
+}
+
+const JsonValue::Member* JsonValue::ObjectType::find(std::string_view key) const
+{
+	if (m_members.size() <= kObjectScanLimit)
+		return scan(key);
+	return lookup(key, std::hash<std::string_view>()(key));
+}
+
+JsonValue::Member* JsonValue::ObjectType::find(std::string_view key, size_t hash)
+{
+	return const_cast<Member*>(std::as_const(*this).find(key, hash));
+}
+
+const JsonValue::Member* JsonValue::ObjectType::find(std::string_view key, size_t hash) const
+{
+	if (m_members.size() <= kObjectScanLimit)
+		return scan(key);
+	return lookup(key, hash);
+}
+
+const JsonValue::Member* JsonValue::ObjectType::scan(std::string_view key) const
+{
+	for (const Member& member : m_members)
 	{
-		std::get<ObjectType>(m_var).clear();
+		if (member.key.getStringView() == key)
+			return &member;
 	}
+	return nullptr;
 }
 
-bool JsonValue::empty() const // is array or object empty
+const JsonValue::Member* JsonValue::ObjectType::lookup(std::string_view key, size_t hash) const
 {
-	assert(m_valueType == eArray || m_valueType == eObject);
-	if (m_valueType == eArray)
+	assert(!m_index.empty());
+	size_t mask = m_index.size() - 1;
+	for (size_t slot = hash & mask; m_index[slot] != 0; slot = (slot + 1) & mask)
 	{
-		assert(m_var.index() == 2);
-		return std::get<ArrayType>(m_var).empty();
+		const Member& member = m_members[m_index[slot] - 1];
+		if (member.key.getStringView() == key)
+			return &member;
 	}
-	else
+	return nullptr;
+}
+
+JsonValue& JsonValue::ObjectType::add(JsonValue&& key, JsonValue&& value)
+{
+	assert(key.isString() && find(key.getStringView()) == nullptr);
+	m_members.push_back(Member{ std::move(key), std::move(value) });
+	if (m_members.size() > kObjectScanLimit)
 	{
-		assert(m_var.index() == 3);
-		return std::get<ObjectType>(m_var).empty();
+		if (m_members.size() * 2 > m_index.size())
+			buildIndex();
+		else
+			indexMember(uint32_t(m_members.size() - 1));
 	}
+	return m_members.back().value;
 }
 
-}
\ No newline at end of file
+void JsonValue::ObjectType::erase(Member* member)
+{
+	m_members.erase(m_members.begin() + (member - m_members.data()));
+	if (m_members.size() > kObjectScanLimit)
+		buildIndex();
+	else
+		m_index.clear();
+}
+
+void JsonValue::ObjectType::buildIndex() // at most 1/4 full after building
+{
+	size_t capacity = 64;
+	while (capacity < m_members.size() * 4)
+		capacity *= 2;
+	m_index.assign(capacity, 0);
+	for (size_t i = 0; i < m_members.size(); i++)
+		indexMember(uint32_t(i));
+}
+
+void JsonValue::ObjectType::indexMember(uint32_t position)
+{
+	size_t mask = m_index.size() - 1;
+	size_t slot = std::hash<std::string_view>()(m_members[position].key.getStringView()) & mask;
+	while (m_index[slot] != 0)
+		slot = (slot + 1) & mask;
+	m_index[slot] = position + 1;
+}
+
+}
@@ -1,3 +1,4 @@
+#include <charconv> // for to_chars
 #include "JsonWriter.h"
 
 namespace MyJson
@@ -97,12 +98,21 @@ void JsonWriter::writeJsonRaw(const JsonValue& value, std::string& json)
 	case eNumber:
 		json += std::to_string(value.getNumber()); // avoid precision lost
 		break;
+	case eInt64:
+	case eUint64:
+		{
+			char buf[24]; // 20 digits and sign at most
+			std::to_chars_result ret = value.type() == eInt64 ? std::to_chars(buf, buf + sizeof(buf), value.getInt64())
+				: std::to_chars(buf, buf + sizeof(buf), value.getUint64());
+			json.append(buf, ret.ptr);
+		}
+		break;
 	case eString:
 		{
 			using namespace std::string_literals;
 			static const std::string hex = "0123456789ABCDEF"s;
 			json += "\"";
-			const std::string& str = value.getString();
+			std::string_view str = value.getStringView(); // borrowed strings are written without being copied
 			for (int i = 0; i < str.length(); i++)
 			{
 				unsigned char ch = str[i];
@@ -161,14 +171,16 @@ void JsonWriter::writeJsonRaw(const JsonValue& value, std::string& json)
 		}
 		json += "{";
 		writeLineFeed(json);
-		std::vector<std::string> keys = value.getKeys();
+		std::vector<std::string_view> keys = value.getKeyViews();
 		for (int i = 0; i < keys.size(); i++)
 		{
 			if (i == 0)
 				writeIndentationBegin(json);
 			else
 				writeIndentation(json);
-			json += ("\"" + keys[i] + "\"");
+			json += "\"";
+			json += keys[i];
+			json += "\"";
 			json += ": ";
 			writeJsonRaw(value.get(keys[i]), json);
 			if (i < keys.size() - 1)
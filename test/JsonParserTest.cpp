@@ -1,8 +1,23 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <new>
+#include <memory>
+#include <thread>
+#include <atomic>
 #include "JsonParser.h"
 #include "JsonWriter.h"
+#include "JsonDocument.h"
+#include "JsonPushParser.h"
+#include "JsonLinesParser.h"
+#include "JsonArrayParser.h"
+#include "JsonLazyDocument.h"
+#include "JsonPointer.h"
 
 using namespace std::string_literals;
 using namespace MyJson;
@@ -11,6 +26,7 @@ using namespace MyJson;
 static int main_ret = 0;
 static int test_count = 0;
 static int test_pass = 0;
+static ParseEngine test_engine = eRecursiveEngine; // engine used by the parse tests
 
 // test failed, print: file, line, expect, actual
 #define EXPECT_EQ_BASE(equality, expect, actual, format) \
@@ -36,8 +52,12 @@ static int test_pass = 0;
 	do{\
 		JsonValue value;\
 		JsonParser parser;\
-		EXPECT_EQ_INT(ret, parser.parseJson(value, json));\
+		parser.setParseEngine(test_engine);\
+		std::string parseLoc, validateLoc;\
+		EXPECT_EQ_INT(ret, parser.parseJson(value, json, parseLoc));\
 		EXPECT_EQ_INT(t, value.type());\
+		EXPECT_EQ_INT(ret, parser.validate(json, validateLoc));\
+		EXPECT_EQ_STRING(parseLoc, validateLoc);\
 	} while(0)
 
 #define TEST_ERROR(ret, json) TEST_RET_TYPE(json, ret, eNull)
@@ -46,17 +66,32 @@ static int test_pass = 0;
 	do {\
 		JsonValue value; \
 		JsonParser parser;\
+		parser.setParseEngine(test_engine);\
 		EXPECT_EQ_INT(eOk, parser.parseJson(value, json)); \
-		EXPECT_EQ_INT(eNumber, value.type()); \
+		EXPECT_EQ_BOOL(true, value.isNumber()); \
+		EXPECT_EQ_INT(eOk, parser.validate(json));\
 		EXPECT_EQ_DOUBLE(val, value.getNumber());\
 } while (0)
 
+#define TEST_INTEGER(t, getter, val, json)\
+	do {\
+		JsonValue value; \
+		JsonParser parser;\
+		parser.setParseEngine(test_engine);\
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, json)); \
+		EXPECT_EQ_INT(t, value.type()); \
+		EXPECT_EQ_INT(eOk, parser.validate(json));\
+		EXPECT_EQ_BOOL(true, value.getter() == val);\
+} while (0)
+
 #define TEST_STRING(val, json)\
 	do{\
 		JsonValue value;\
 		JsonParser parser;\
+		parser.setParseEngine(test_engine);\
 		EXPECT_EQ_INT(eOk, parser.parseJson(value, json));\
 		EXPECT_EQ_INT(eString, value.type());\
+		EXPECT_EQ_INT(eOk, parser.validate(json));\
 		EXPECT_EQ_STRING(val, value.getString());\
 	} while (0)
 
@@ -114,6 +149,102 @@ static void test_parse_number()
 	TEST_NUMBER(1e-1000, "1e-1000"); // too small to 0
 }
 
+static void test_parse_integer()
+{
+	TEST_INTEGER(eInt64, getInt64, 0, "0");
+	TEST_INTEGER(eInt64, getInt64, 1, "1");
+	TEST_INTEGER(eInt64, getInt64, -1, "-1");
+	TEST_INTEGER(eInt64, getInt64, 1234567890123456789, "1234567890123456789");
+	TEST_INTEGER(eInt64, getInt64, INT64_MAX, "9223372036854775807");
+	TEST_INTEGER(eInt64, getInt64, INT64_MIN, "-9223372036854775808");
+	TEST_INTEGER(eUint64, getUint64, 9223372036854775808u, "9223372036854775808");
+	TEST_INTEGER(eUint64, getUint64, UINT64_MAX, "18446744073709551615");
+	TEST_INTEGER(eUint64, getUint64, 10000000000000000000u, "10000000000000000000");
+	// not integers, or out of range
+	TEST_INTEGER(eNumber, getNumber, 18446744073709551616.0, "18446744073709551616");
+	TEST_INTEGER(eNumber, getNumber, 99999999999999999999.0, "99999999999999999999");
+	TEST_INTEGER(eNumber, getNumber, -9223372036854775809.0, "-9223372036854775809");
+	TEST_INTEGER(eNumber, getNumber, 1.0, "1.0");
+	TEST_INTEGER(eNumber, getNumber, 1.0, "1e0");
+	TEST_INTEGER(eNumber, getNumber, 0.0, "-0");
+
+	// integers are written without float formatting and read back exactly
+	JsonValue value;
+	value.append(INT64_MIN);
+	value.append(UINT64_MAX);
+	value.append(-42);
+	std::string json;
+	JsonWriter writer(false);
+	writer.writeJson(value, json);
+	EXPECT_EQ_STRING("[-9223372036854775808,18446744073709551615,-42]"s, json);
+	JsonValue readBack;
+	JsonParser parser;
+	EXPECT_EQ_INT(eOk, parser.parseJson(readBack, json));
+	EXPECT_EQ_BOOL(true, readBack == value);
+	EXPECT_EQ_BOOL(true, JsonValue(1) == JsonValue(1.0));
+	EXPECT_EQ_BOOL(true, JsonValue(uint64_t(7)) == JsonValue(7));
+	EXPECT_EQ_BOOL(false, JsonValue(-1) == JsonValue(UINT64_MAX));
+}
+
+// the built-in conversion must give exactly the same double as strtod
+static void test_parse_number_rounding()
+{
+	auto expectSameAsStrtod = [](const std::string& json) {
+		errno = 0;
+		double expect = strtod(json.c_str(), NULL);
+		bool tooBig = (errno == ERANGE && (expect == HUGE_VAL || expect == -HUGE_VAL));
+		JsonValue value;
+		JsonParser parser;
+		parser.setParseEngine(test_engine);
+		int ret = parser.parseJson(value, json);
+		EXPECT_EQ_INT(tooBig ? eNumberTooBig : eOk, ret);
+		if (ret == eOk)
+		{
+			double actual = value.getNumber();
+			bool same = memcmp(&expect, &actual, sizeof(double)) == 0;
+			EXPECT_EQ_BASE(same, json.c_str(), json.c_str(), "%s");
+		}
+	};
+	const std::string cases[] = {
+		"9007199254740993", "9007199254740992.5", "-9007199254740995", "18014398509481985",
+		"2.2250738585072011e-308", "2.2250738585072012e-308", "4.9406564584124654e-324", "2.4703282292062327e-324",
+		"2.4703282292062328e-324", "1.7976931348623158e308", "1.7976931348623159e308", "1e23", "8.98846567431158e307",
+		"0.1", "0.3", "123456789012345678901234567890", "0.000000000000000000000000000001234567890123456789012345",
+		"7.038531e-26", "9223372036854775807", "18446744073709551615", "18446744073709551616", "1448997445238699",
+		"1.00000000000000011102230246251565404236316680908203125",
+		"1.00000000000000011102230246251565404236316680908203124999999999999999999999999999999999999999999999999",
+		"1.00000000000000011102230246251565404236316680908203125000000000000000000000000000000000000000000000001",
+		"2.225073858507201136057409796709131975934819546351645648e-308", "0e99999999999", "-0.0e-99999999999",
+		"1e-99999999999", "1e99999999999", "1" + std::string(400, '0'), "0." + std::string(400, '0') + "1",
+		"1" + std::string(1000, '0') + "e-1000", "4.94065645841246544176568792868221372365059802614324764425585682500675507270208751865299836361635992379796564695445717730926656710355939796398774796010781878126300713190311404527845817167848982103688718636056998730723050006387409153564984387312473397273169615140031715385398074126238565591171026658556686768187039560310624931945271591492455329305456544401127480129709999541931989409080416563324524757147869014726780159355238611550134803526493472019379026810710749170333222684475333572083243193609238289345836806010601150616980975307834227731832924790498252473077637592724787465608477820373446969953364701797267771758512566055119913150489110145103786273816725095583738973359899366480994116420570263709027924276754456522908753868250641971826553344726562499999999999999999999e-324",
+	};
+	for (const std::string& json : cases)
+		expectSameAsStrtod(json);
+
+	unsigned int seed = 2022;
+	auto next = [&seed]() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0x7FFF; };
+	for (int n = 0; n < 20000; n++)
+	{
+		std::string json;
+		if (next() % 2)
+			json += '-';
+		int intDigits = next() % 20 + 1;
+		json += char('1' + next() % 9);
+		for (int i = 1; i < intDigits; i++)
+			json += char('0' + next() % 10);
+		if (next() % 2)
+		{
+			json += '.';
+			int fracDigits = next() % 20 + 1;
+			for (int i = 0; i < fracDigits; i++)
+				json += char('0' + next() % 10);
+		}
+		if (next() % 4)
+			json += "e" + std::to_string(int(next() % 700) - 350);
+		expectSameAsStrtod(json);
+	}
+}
+
 static void test_parse_string()
 {
 	TEST_STRING(""s, "\"\"");	// ""
@@ -129,6 +260,23 @@ static void test_parse_string()
 	// unicode surrogates
 	TEST_STRING("\xF0\x9D\x84\x9E"s, "\"\\uD834\\uDD1E\"");  // G clef sign U+1D11E
 	TEST_STRING("\xF0\x9D\x84\x9E"s, "\"\\ud834\\udd1e\"");  // G clef sign U+1D11E
+	// long strings, escapes and errors at every position across block boundaries
+	for (size_t len = 0; len < 80; len++)
+	{
+		std::string plain(len, 'a');
+		TEST_STRING(plain, "\"" + plain + "\"");
+		for (size_t pos = 0; pos < len; pos++)
+		{
+			std::string expect = plain, json = plain;
+			expect[pos] = '\n';
+			json.replace(pos, 1, "\\n");
+			TEST_STRING(expect, "\"" + json + "\"");
+			json = plain;
+			json[pos] = '\x1F';
+			TEST_ERROR(eInvalidStringChar, "\"" + json + "\"");
+		}
+		TEST_ERROR(eMissQuatationMark, "\"" + plain);
+	}
 }
 
 static void test_parse_array()
@@ -142,6 +290,7 @@ static void test_parse_array()
 	// test the element of array
 	JsonValue value;
 	JsonParser parser;
+	parser.setParseEngine(test_engine);
 	int result = parser.parseJson(value, "[ 1.0e-100 , null , true, false, [1.59E100,\"hello\"], \"world\"]");
 	EXPECT_EQ_INT(eOk, result);
 	EXPECT_EQ_SIZE_T(value.size(), 6);
@@ -171,6 +320,7 @@ static void test_parse_object()
 	// test the element of object
 	JsonValue value;
 	JsonParser parser;
+	parser.setParseEngine(test_engine);
 	int ret = parser.parseJson(value, "{\"a\" : null, \"b\": false, \"c\" : {\"d\" : []}}");
 	EXPECT_EQ_INT(eOk, ret);
 	EXPECT_EQ_INT(eObject, value.type());
@@ -263,6 +413,29 @@ static void test_parse_invalid_string_char()
 	TEST_ERROR(eInvalidStringChar, "\"\x1F\"");
 }
 
+static void test_parse_invalid_utf8()
+{
+	TEST_STRING("\x7F\xC2\x80\xDF\xBF\xE0\xA0\x80\xED\x9F\xBF\xEE\x80\x80\xF0\x90\x80\x80\xF4\x8F\xBF\xBF"s,
+		"\"\x7F\xC2\x80\xDF\xBF\xE0\xA0\x80\xED\x9F\xBF\xEE\x80\x80\xF0\x90\x80\x80\xF4\x8F\xBF\xBF\"");
+	TEST_ERROR(eInvalidUtf8, "\"\x80\"");				// lone continuation byte
+	TEST_ERROR(eInvalidUtf8, "\"a\xBF\"");
+	TEST_ERROR(eInvalidUtf8, "\"\xC0\xAF\"");			// overlong '/'
+	TEST_ERROR(eInvalidUtf8, "\"\xC1\xBF\"");
+	TEST_ERROR(eInvalidUtf8, "\"\xE0\x9F\xBF\"");		// overlong 3 bytes
+	TEST_ERROR(eInvalidUtf8, "\"\xF0\x8F\xBF\xBF\"");	// overlong 4 bytes
+	TEST_ERROR(eInvalidUtf8, "\"\xED\xA0\x80\"");		// encoded surrogate U+D800
+	TEST_ERROR(eInvalidUtf8, "\"\xED\xBF\xBF\"");
+	TEST_ERROR(eInvalidUtf8, "\"\xF4\x90\x80\x80\"");	// above U+10FFFF
+	TEST_ERROR(eInvalidUtf8, "\"\xF5\x80\x80\x80\"");
+	TEST_ERROR(eInvalidUtf8, "\"\xFF\"");
+	TEST_ERROR(eInvalidUtf8, "\"\xC2\"");				// incomplete
+	TEST_ERROR(eInvalidUtf8, "\"\xE2\x82\"");
+	TEST_ERROR(eInvalidUtf8, "\"\xF0\x9D\x84\\n\"");
+	TEST_ERROR(eInvalidUtf8, "\"\xE2\x82\xAC\xE2\x82\xAC\x82\"");	// too long
+	TEST_ERROR(eInvalidUtf8, "{\"\xC0\x80\": 1}");		// in a key
+	TEST_ERROR(eInvalidUtf8, "[\"ok\", \"\\n\xFE\"]");
+}
+
 static void test_parse_invalid_unicode_hex()
 {
 	// string
@@ -349,6 +522,24 @@ static void test_access_number()
 	EXPECT_EQ_INT(value.type(), eNumber);
 	EXPECT_EQ_DOUBLE(value.getNumber(), 1e-100);
 	EXPECT_EQ_BOOL(value.isNumber(), true);
+	EXPECT_EQ_BOOL(value.isInt64(), false);
+
+	value.setInt64(-5);
+	EXPECT_EQ_INT(value.type(), eInt64);
+	EXPECT_EQ_BOOL(value.isNumber(), true);
+	EXPECT_EQ_BOOL(value.isInt64(), true);
+	EXPECT_EQ_BOOL(value.isUint64(), false);
+	EXPECT_EQ_DOUBLE(value.getNumber(), -5.0);
+
+	value.setUint64(UINT64_MAX);
+	EXPECT_EQ_INT(value.type(), eUint64);
+	EXPECT_EQ_BOOL(value.isInt64(), false);
+	EXPECT_EQ_BOOL(value.isUint64(), true);
+	EXPECT_EQ_BOOL(true, value.getUint64() == UINT64_MAX);
+
+	value.setUint64(5);
+	EXPECT_EQ_BOOL(value.isInt64(), true);
+	EXPECT_EQ_BOOL(true, value.getInt64() == 5);
 }
 
 static void test_access_string()
@@ -359,6 +550,11 @@ static void test_access_string()
 	EXPECT_EQ_STRING(value.getString(), ""s);
 	value.setString("\0\0hello", 7);
 	EXPECT_EQ_STRING(value.getString(), "\0\0hello"s);
+	std::string_view view("\0world", 6);
+	value.setStringView(view);
+	EXPECT_EQ_BOOL(true, value.isBorrowedString());
+	EXPECT_EQ_BOOL(true, value.getStringView().data() == view.data());
+	EXPECT_EQ_BOOL(true, value.getStringView() == "\0world"s);
 }
 
 static void test_access_array()
@@ -406,6 +602,32 @@ static void test_access_object()
 	value.clear();
 	EXPECT_EQ_SIZE_T(0, value.size());
 	EXPECT_EQ_BOOL(true, value.empty());
+
+	// const reads change nothing, threads can look keys up in one value at once: the index of a large object is built
+	// as it grows, borrowed strings are read as views
+	std::string json = "{";
+	for (int i = 0; i < 200; i++)
+		json += (i ? ", \"key"s : "\"key"s) + std::to_string(i) + "\": \"value" + std::to_string(i) + "\"";
+	json += "}";
+	JsonParser parser;
+	parser.setBorrowStrings(true);
+	EXPECT_EQ_INT(eOk, parser.parseJson(value, json));
+	const JsonValue& shared = value;
+	std::atomic<int> wrong(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&shared, &wrong]() {
+			for (int round = 0; round < 50; round++)
+				for (int i = 0; i < 200; i++)
+					wrong += shared.get("key" + std::to_string(i)).getStringView() != "value" + std::to_string(i);
+		});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+	EXPECT_EQ_INT(0, wrong.load());
+	value.removeKey("key0"); // the index follows removals too
+	EXPECT_EQ_BOOL(true, !value.containsKey("key0") && value.get("key199").getStringView() == "value199");
 }
 
 static void test_parse()
@@ -414,6 +636,8 @@ static void test_parse()
 	test_parse_true();
 	test_parse_false();
 	test_parse_number();
+	test_parse_number_rounding();
+	test_parse_integer();
 	test_parse_string();
 	test_parse_object();
 	test_parse_expect_value();
@@ -423,6 +647,7 @@ static void test_parse()
 	test_parse_miss_quotation_mark();
 	test_parse_invalid_string_escape();
 	test_parse_invalid_string_char();
+	test_parse_invalid_utf8();
 	test_parse_invalid_unicode_hex();
 	test_parse_invalid_unicode_surrogate();
 	test_parse_miss_comma_or_square_bracket();
@@ -454,6 +679,14 @@ static void test_write()
 	JsonValue tmpValue;
 	EXPECT_EQ_INT(eOk, parser.parseJson(tmpValue, outputJson));
 	EXPECT_EQ_BOOL(true, tmpValue == value);
+
+	// keys are written in their source order, a repeated key keeps its first place and its last value
+	json = "{\"z\":1,\"a\":{\"y\":[],\"b\":{}},\"m\":\"x\",\"a\":{\"c\":null}}";
+	EXPECT_EQ_INT(eOk, parser.parseJson(value, json));
+	JsonWriter compact(false);
+	outputJson.clear();
+	compact.writeJson(value, outputJson);
+	EXPECT_EQ_STRING("{\"z\": 1,\"a\": {\"c\": null},\"m\": \"x\"}"s, outputJson);
 }
 
 static void test_value_api()
@@ -529,8 +762,271 @@ static void test_value_api()
 		value.clear();
 		EXPECT_EQ_SIZE_T(0, value.size());
 	}
+
+	// a value can take over or copy a part of itself
+	{
+		JsonValue value;
+		value["a"].append("first");
+		value["a"].append(JsonValue(eObject));
+		value["a"][1]["b"] = 2;
+		value = value["a"];
+		EXPECT_EQ_SIZE_T(2, value.size());
+		EXPECT_EQ_STRING("first"s, value[0].getString());
+		value = std::move(value[1]);
+		EXPECT_EQ_BOOL(true, value.isObject() && value.get("b").getInt64() == 2);
+		value = value;
+		EXPECT_EQ_BOOL(true, value.isObject() && value.get("b").getInt64() == 2);
+
+		// changing the type releases what the value had
+		value.setType(eString);
+		EXPECT_EQ_STRING(""s, value.getString());
+		value.setType(eTrue);
+		EXPECT_EQ_BOOL(true, value.getBool());
+		if (sizeof(void*) == 8)
+			EXPECT_EQ_SIZE_T(16, sizeof(JsonValue));
+	}
+
+	// object keeps insertion order, large objects are looked up through the hash index
+	{
+		for (int size : { 10, 16, 17, 100 }) // equal in any order, below and above the scan limit
+		{
+			JsonValue forward, backward;
+			for (int i = 0; i < size; i++)
+			{
+				forward["key"s + std::to_string(i)] = i;
+				backward["key"s + std::to_string(size - 1 - i)] = size - 1 - i;
+			}
+			EXPECT_EQ_BOOL(true, forward == backward);
+			backward["key0"s] = -1;
+			EXPECT_EQ_BOOL(false, forward == backward);
+		}
+		JsonValue value;
+		for (int i = 0; i < 200; i++)
+			value["key"s + std::to_string(199 - i)] = i;
+		auto keys = value.getKeys();
+		EXPECT_EQ_STRING("key199"s, keys[0]);
+		EXPECT_EQ_STRING("key0"s, keys[199]);
+		for (int i = 0; i < 200; i++)
+			EXPECT_EQ_BOOL(true, value.get("key"s + std::to_string(i)).getInt64() == 199 - i);
+		EXPECT_EQ_BOOL(false, value.containsKey("key200"));
+
+		value.appendKey("key5", "replaced");
+		EXPECT_EQ_SIZE_T(200, value.size());
+		EXPECT_EQ_STRING("key5"s, value.getKeys()[194]);
+		for (int i = 0; i < 200; i += 2)
+			EXPECT_EQ_BOOL(true, value.removeKey("key"s + std::to_string(i)));
+		EXPECT_EQ_SIZE_T(100, value.size());
+		EXPECT_EQ_STRING("key199"s, value.getKeys()[0]);
+		EXPECT_EQ_STRING("replaced"s, value.get("key5").getString());
+		for (int i = 0; i < 200; i++)
+			EXPECT_EQ_BOOL(i % 2 == 1, value.containsKey("key"s + std::to_string(i)));
+		value["key0"] = 0;
+		EXPECT_EQ_STRING("key0"s, value.getKeys()[100]);
+		EXPECT_EQ_BOOL(true, value.get("key0").getInt64() == 0);
+	}
 }
  
+// counts what an arena asks from upstream
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+	int allocations = 0;
+	int outstanding = 0;
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		allocations++;
+		outstanding++;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override
+	{
+		outstanding--;
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+};
+
+// counts the global heap while enabled, to check what a parse allocates
+static bool heap_counting = false;
+static size_t heap_allocations = 0;
+static size_t heap_bytes = 0;
+
+void* operator new(size_t bytes)
+{
+	if (heap_counting)
+	{
+		heap_allocations++;
+		heap_bytes += bytes;
+	}
+	void* p = malloc(bytes ? bytes : 1);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+static void start_heap_counting()
+{
+	heap_allocations = 0;
+	heap_bytes = 0;
+	heap_counting = true;
+}
+
+static void stop_heap_counting()
+{
+	heap_counting = false;
+}
+
+// parse events written as text, to compare with the events of a parsed value
+class TraceHandler
+{
+public:
+	std::string trace;
+	void null() { trace += "n "; }
+	void boolean(bool b) { trace += b ? "t " : "f "; }
+	void number(double d) { trace += "d" + std::to_string(d) + " "; }
+	void int64(int64_t i) { trace += "i" + std::to_string(i) + " "; }
+	void uint64(uint64_t u) { trace += "u" + std::to_string(u) + " "; }
+	void string(std::string_view str) { trace += "s" + std::to_string(str.size()) + ":" + std::string(str) + " "; }
+	void startObject() { trace += "{ "; }
+	void key(std::string_view key) { trace += "k" + std::to_string(key.size()) + ":" + std::string(key) + " "; }
+	void endObject(size_t memberCount) { trace += "}" + std::to_string(memberCount) + " "; }
+	void startArray() { trace += "[ "; }
+	void endArray(size_t elementCount) { trace += "]" + std::to_string(elementCount) + " "; }
+
+	void traceValue(const JsonValue& value)
+	{
+		switch (value.type())
+		{
+		case eNull: null(); break;
+		case eTrue: boolean(true); break;
+		case eFalse: boolean(false); break;
+		case eNumber: number(value.getNumber()); break;
+		case eInt64: int64(value.getInt64()); break;
+		case eUint64: uint64(value.getUint64()); break;
+		case eString: string(value.getStringView()); break;
+		case eArray:
+			startArray();
+			for (size_t i = 0; i < value.size(); i++)
+				traceValue(value[i]);
+			endArray(value.size());
+			break;
+		case eObject:
+			startObject();
+			for (std::string_view k : value.getKeyViews())
+			{
+				key(k);
+				traceValue(value.get(k));
+			}
+			endObject(value.size());
+			break;
+		}
+	}
+};
+
+// only sums the numbers
+class SumHandler
+{
+public:
+	double sum = 0;
+	size_t values = 0;
+	void null() { values++; }
+	void boolean(bool) { values++; }
+	void number(double d) { sum += d; values++; }
+	void int64(int64_t i) { sum += double(i); values++; }
+	void uint64(uint64_t u) { sum += double(u); values++; }
+	void string(std::string_view) { values++; }
+	void startObject() {}
+	void key(std::string_view) {}
+	void endObject(size_t) { values++; }
+	void startArray() {}
+	void endArray(size_t) { values++; }
+};
+
+// offset of the first invalid UTF-8 sequence, npos if there is none, a plain decoder to check the vectorized one
+static size_t first_invalid_utf8(const std::string& str)
+{
+	size_t i = 0;
+	while (i < str.size())
+	{
+		unsigned char ch = str[i];
+		size_t length = ch < 0x80 ? 1 : ch < 0xC2 ? 0 : ch < 0xE0 ? 2 : ch < 0xF0 ? 3 : ch < 0xF5 ? 4 : 0;
+		if (length == 0 || i + length > str.size())
+			return i;
+		unsigned int u = length == 1 ? ch : ch & (0x7F >> length);
+		for (size_t j = 1; j < length; j++)
+		{
+			if (((unsigned char)str[i + j] & 0xC0) != 0x80)
+				return i;
+			u = (u << 6) | (str[i + j] & 0x3F);
+		}
+		static const unsigned int smallest[] = { 0, 0, 0x80, 0x800, 0x10000 };
+		if (u < smallest[length] || u > 0x10FFFF || (u >= 0xD800 && u <= 0xDFFF))
+			return i;
+		i += length;
+	}
+	return std::string::npos;
+}
+
+// every value under the cursor reads the same as the value JsonParser builds
+static void test_lazy_value(const JsonValue& value, const JsonCursor& cursor)
+{
+	EXPECT_EQ_BOOL(true, cursor.exists());
+	EXPECT_EQ_INT(value.type(), cursor.type());
+	EXPECT_EQ_BOOL(value.isNumber(), cursor.isNumber());
+	EXPECT_EQ_BOOL(value.isBool(), cursor.isBool());
+	switch (value.type())
+	{
+	case eTrue:
+	case eFalse:
+		EXPECT_EQ_BOOL(value.getBool(), cursor.getBool());
+		break;
+	case eNumber:
+	case eInt64:
+	case eUint64:
+		EXPECT_EQ_DOUBLE(value.getNumber(), cursor.getNumber());
+		EXPECT_EQ_BOOL(true, cursor.getInt64() == (value.isInt64() ? value.getInt64() : 0));
+		EXPECT_EQ_BOOL(true, cursor.getUint64() == (value.isUint64() ? value.getUint64() : 0));
+		break;
+	case eString:
+		EXPECT_EQ_STRING(value.getString(), cursor.getString());
+		break;
+	case eArray:
+		EXPECT_EQ_SIZE_T(value.size(), cursor.size());
+		for (size_t i = 0; i < value.size(); i++)
+			test_lazy_value(value[i], cursor[i]);
+		EXPECT_EQ_BOOL(false, cursor[value.size()].exists());
+		break;
+	case eObject:
+		EXPECT_EQ_SIZE_T(value.size(), cursor.size());
+		for (const std::string& key : value.getKeys())
+		{
+			EXPECT_EQ_BOOL(true, cursor.containsKey(key));
+			test_lazy_value(value.get(key), cursor[key]);
+		}
+		EXPECT_EQ_BOOL(false, cursor.containsKey("not a key"));
+		break;
+	default:
+		break;
+	}
+	JsonValue parsed;
+	EXPECT_EQ_INT(eOk, cursor.parse(parsed));
+	EXPECT_EQ_BOOL(true, parsed == value);
+}
+
 static void test_parser_api()
 {
 	// error infomation
@@ -562,6 +1058,1243 @@ static void test_parser_api()
 		EXPECT_EQ_INT(eOk, parser.parseJson(value, json, errInfo));
 		EXPECT_EQ_INT(0, parser.errorLine());
 		EXPECT_EQ_INT(0, parser.errorColumn());
+
+		// the position is there without the error information too, and is gone after a success
+		parser.setParseLFStyle(eCRLFAll);
+		json = "[1,\r\n 2,\n\n  x]";
+		EXPECT_EQ_INT(eInvalidValue, parser.parseJson(value, json));
+		EXPECT_EQ_INT(4, parser.errorLine());
+		EXPECT_EQ_INT(3, parser.errorColumn());
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, "[1,\n2]"));
+		EXPECT_EQ_INT(0, parser.errorLine());
+		EXPECT_EQ_INT(0, parser.errorColumn());
+		EXPECT_EQ_INT(eInvalidValue, parser.validate(json));
+		EXPECT_EQ_INT(4, parser.errorLine());
+		EXPECT_EQ_INT(3, parser.errorColumn());
+
+		// a missing comma at the end of a view is located in the view, not at the byte after it
+		const char text[] = "[1\n";
+		std::string_view view(text, 2);
+		EXPECT_EQ_INT(eArrayMissCommaOrSquareBracket, parser.parseJson(value, view, errInfo));
+		EXPECT_EQ_STRING("line 1, column 4: Array miss comma(,) or square bracket([)."s, errInfo);
+		EXPECT_EQ_INT(eArrayMissCommaOrSquareBracket, parser.validate(view));
+		EXPECT_EQ_INT(1, parser.errorLine());
+		EXPECT_EQ_INT(4, parser.errorColumn());
+		JsonPushParser pushParser;
+		pushParser.feed(view.data(), view.size());
+		EXPECT_EQ_INT(eArrayMissCommaOrSquareBracket, pushParser.finish(value));
+		EXPECT_EQ_INT(1, pushParser.errorLine());
+		EXPECT_EQ_INT(4, pushParser.errorColumn());
+
+		// an escaped line break unescaped in situ before the error is not a new line
+		json = "[\"a\\nb\\r\", \n x]";
+		std::string buf = json;
+		EXPECT_EQ_INT(eInvalidValue, parser.parseJsonInSitu(value, &buf[0], buf.size()));
+		EXPECT_EQ_INT(2, parser.errorLine());
+		EXPECT_EQ_INT(2, parser.errorColumn());
+	}
+
+	// long white space runs, line breaks across block boundaries
+	{
+		// line and column of the first non-white-space character, counted byte by byte
+		auto expectPosition = [](const std::string& json, LFStyle style, int& line, int& column) {
+			line = 1;
+			size_t head = 0, i = 0;
+			for (; json[i] == ' ' || json[i] == '\t' || json[i] == '\r' || json[i] == '\n'; i++)
+			{
+				bool cr = json[i] == '\r', lf = json[i] == '\n';
+				bool crBefore = i > 0 && json[i - 1] == '\r';
+				if ((style == eCR && cr) || (style == eLF && lf) || (style == eCRLF && lf && crBefore)
+					|| (style == eCRLFAll && (cr || (lf && !crBefore))))
+					line++;
+				if ((style == eCR && cr) || (style == eLF && lf) || (style == eCRLF && lf && crBefore)
+					|| (style == eCRLFAll && (cr || lf)))
+					head = i + 1;
+			}
+			column = int(i - head + 1);
+		};
+		const char* pieces[] = { " ", "\t", "\r", "\n", "\r\n", "\n\r", "\r\r", "        " };
+		const LFStyle styles[] = { eCR, eLF, eCRLF, eCRLFAll };
+		unsigned int seed = 12345;
+		for (int n = 0; n < 200; n++)
+		{
+			std::string json;
+			int count = n % 50;
+			for (int i = 0; i < count; i++)
+			{
+				seed = seed * 1103515245 + 12345;
+				json += pieces[(seed >> 16) % 8];
+			}
+			json += "?";
+			for (LFStyle style : styles)
+			{
+				JsonValue value;
+				JsonParser parser;
+				std::string errInfo;
+				int line = 0, column = 0;
+				expectPosition(json, style, line, column);
+				parser.setParseLFStyle(style);
+				EXPECT_EQ_INT(eInvalidValue, parser.parseJson(value, json, errInfo));
+				EXPECT_EQ_INT(line, parser.errorLine());
+				EXPECT_EQ_INT(column, parser.errorColumn());
+			}
+		}
+	}
+
+	// structural index and iterative engines give the same value, error and position as the recursive engine
+	{
+		std::string base = "{\"a\" : [1, -2.5e3, true, false, null, \"x\\\"y\\\\\"],\r\n\t\"b\" : {\"c\" : \"\\u20AC{[,:]}\", \"d\" : []},\n"
+			"\t\"e\\\\\" : \"\\\\\\\\\", \"f\" : [[{}], {\"g\":0}], \"h\" : \"" + std::string(100, 'z') + "\\\"\"}";
+		const char mutations[] = { ' ', '\n', '\"', '\\', '[', ']', '{', '}', ',', ':', '0', 'e', 'n', '\0' };
+		JsonParser recursive, indexed, iterative;
+		indexed.setParseEngine(eStructuralIndexEngine);
+		iterative.setParseEngine(eIterativeEngine);
+		for (size_t i = 0; i <= base.size(); i++)
+		{
+			for (char ch : mutations)
+			{
+				std::string json = base;
+				if (i < base.size())
+					json[i] = ch;
+				else
+					json += ch;
+				JsonValue value1, value2, value3;
+				std::string errInfo1, errInfo2, errInfo3;
+				int ret1 = recursive.parseJson(value1, json, errInfo1);
+				int ret2 = indexed.parseJson(value2, json, errInfo2);
+				int ret3 = iterative.parseJson(value3, json, errInfo3);
+				EXPECT_EQ_INT(ret1, ret2);
+				EXPECT_EQ_STRING(errInfo1, errInfo2);
+				EXPECT_EQ_BOOL(true, value1 == value2);
+				EXPECT_EQ_INT(ret1, ret3);
+				EXPECT_EQ_STRING(errInfo1, errInfo3);
+				EXPECT_EQ_BOOL(true, value1 == value3);
+			}
+		}
+		JsonValue value;
+		EXPECT_EQ_INT(eOk, indexed.parseJson(value, base));
+		EXPECT_EQ_STRING("\xE2\x82\xAC{[,:]}"s, value["b"s]["c"s].getString());
+		EXPECT_EQ_STRING("\\\\"s, value["e\\"s].getString());
+
+		// the index grows past its first guess when nearly every byte is a structural
+		std::string dense = "[";
+		for (int i = 0; i < 5000; i++)
+			dense += "[],";
+		dense += "1]";
+		JsonParser fresh;
+		fresh.setParseEngine(eStructuralIndexEngine);
+		EXPECT_EQ_INT(eOk, fresh.parseJson(value, dense));
+		EXPECT_EQ_SIZE_T(5001, value.size());
+		EXPECT_EQ_BOOL(true, value[5000].getInt64() == 1);
+	}
+
+	// nesting deeper than the limit is an error at the bracket that opens one level too many, in all engines
+	{
+		for (ParseEngine engine : { eRecursiveEngine, eStructuralIndexEngine, eIterativeEngine })
+		{
+			JsonParser parser;
+			parser.setParseEngine(engine);
+			JsonValue value;
+			std::string errInfo;
+			parser.setMaxDepth(3);
+			EXPECT_EQ_INT(eOk, parser.parseJson(value, "[{\"a\" : [1]}, [[]], {}]"));
+			EXPECT_EQ_INT(eNestingTooDeep, parser.parseJson(value, "[{\"a\" : [1, [2]]}]", errInfo));
+			EXPECT_EQ_INT(1, parser.errorLine());
+			EXPECT_EQ_INT(13, parser.errorColumn());
+			EXPECT_EQ_BOOL(true, value.isNull());
+			EXPECT_EQ_INT(eNestingTooDeep, parser.parseJson(value, "[[[{}]]]", errInfo));
+			EXPECT_EQ_INT(4, parser.errorColumn());
+			parser.setMaxDepth(0);
+			EXPECT_EQ_INT(eOk, parser.parseJson(value, "1"));
+			EXPECT_EQ_INT(eNestingTooDeep, parser.parseJson(value, "[]"));
+
+			// the default limit stops 100k levels before any engine runs out of stack
+			std::string deep = std::string(100000, '[') + std::string(100000, ']');
+			parser.setMaxDepth(JsonParser::kDefaultMaxDepth);
+			EXPECT_EQ_INT(eNestingTooDeep, parser.parseJson(value, deep, errInfo));
+			EXPECT_EQ_INT(int(JsonParser::kDefaultMaxDepth + 1), parser.errorColumn());
+		}
+
+		// the iterative engine only needs heap for deep nesting
+		const int depth = 10000;
+		JsonParser parser;
+		parser.setParseEngine(eIterativeEngine);
+		parser.setMaxDepth(depth);
+		std::string deep = std::string(depth - 1, '[') + "{\"k\" : true}" + std::string(depth - 1, ']');
+		JsonValue value;
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, deep));
+		const JsonValue* inner = &value;
+		for (int i = 1; i < depth; i++)
+			inner = &(*inner)[0];
+		EXPECT_EQ_BOOL(true, inner->get("k").isTrue());
+		EXPECT_EQ_INT(eNestingTooDeep, parser.parseJson(value, "[" + deep + "]"));
+		EXPECT_EQ_BOOL(true, value.isNull());
+	}
+
+	// events follow the text in the order of a parsed value, with the same errors and positions
+	{
+		std::string base = "{\"a\" : [1, -2.5e3, true, false, null, \"x\\\"y\\\\\"],\r\n\t\"b\" : {\"c\" : \"\\u20AC{[,:]}\", \"d\" : []},\n"
+			"\t\"e\\\\\" : 18446744073709551615, \"f\" : [[{}], {\"g\":0}], \"h\" : \"" + std::string(100, 'z') + "\\\"\"}";
+		const char mutations[] = { ' ', '\n', '\"', '\\', '[', ']', '{', '}', ',', ':', '0', 'e', 'n', '\0' };
+		JsonParser parser;
+		for (size_t i = 0; i <= base.size(); i++)
+		{
+			for (char ch : mutations)
+			{
+				std::string json = base;
+				if (i < base.size())
+					json[i] = ch;
+				else
+					json += ch;
+				JsonValue value;
+				std::string errInfo1, errInfo2;
+				TraceHandler events, expected;
+				int ret = parser.parseJson(value, json, errInfo1);
+				EXPECT_EQ_INT(ret, parser.parseEvents(events, json, errInfo2));
+				EXPECT_EQ_STRING(errInfo1, errInfo2);
+				if (ret == eOk)
+				{
+					expected.traceValue(value);
+					EXPECT_EQ_STRING(expected.trace, events.trace);
+				}
+			}
+		}
+		TraceHandler events;
+		EXPECT_EQ_INT(eOk, parser.parseEvents(events, "[{\"k\\n\" : -1}, [], 0.5, \"\"]"));
+		EXPECT_EQ_STRING("[ { k2:k\n i-1 }1 [ ]0 d0.500000 s0: ]4 "s, events.trace);
+		parser.setMaxDepth(2);
+		EXPECT_EQ_INT(eNestingTooDeep, parser.parseEvents(events, "[[[]]]"));
+		parser.setMaxDepth(JsonParser::kDefaultMaxDepth);
+
+		SumHandler sum;
+		EXPECT_EQ_INT(eOk, parser.parseEvents(sum, "[{\"a\" : 1, \"b\" : [2.5, \"3\"]}, 4]"));
+		EXPECT_EQ_BOOL(true, sum.sum == 7.5);
+		EXPECT_EQ_SIZE_T(7, sum.values);
+	}
+
+	// a text fed in chunks of any size gives the same value, error and position as the whole text
+	{
+		std::string base = "{\"a\" : [1, -2.5e3, true, false, null, \"x\\\"y\\\\\"],\r\n\t\"b\" : {\"c\" : \"\\u20AC\\uD834\\uDD1E\", \"d\" : []},\r\r\n\n"
+			"\t\"e\\\\\" : 18446744073709551615, \"f\" : [[{}], {\"g\":0}], \"h\" : \"" + std::string(100, 'z') + "\\\"\"}\r";
+		const char mutations[] = { ' ', '\n', '\r', '\"', '\\', '[', ']', '{', '}', ',', ':', '0', 'e', 'n', '\0' };
+		const size_t chunkSizes[] = { 1, 2, 3, 7, 64 };
+		JsonParser parser;
+		JsonPushParser pushParser;
+		for (size_t i = 0; i <= base.size(); i++)
+		{
+			for (char ch : mutations)
+			{
+				std::string json = base;
+				if (i < base.size())
+					json[i] = ch;
+				else
+					json += ch;
+				LFStyle style = LFStyle(i % 4);
+				parser.setParseLFStyle(style);
+				pushParser.setParseLFStyle(style);
+				JsonValue value1;
+				std::string errInfo;
+				int ret = parser.parseJson(value1, json, errInfo);
+				for (size_t chunkSize : chunkSizes)
+				{
+					JsonValue value2;
+					int fed = eOk;
+					for (size_t pos = 0; pos < json.size() && fed == eOk; pos += chunkSize)
+						fed = pushParser.feed(json.data() + pos, std::min(chunkSize, json.size() - pos));
+					EXPECT_EQ_BOOL(true, fed == eOk || fed == ret);
+					EXPECT_EQ_INT(ret, pushParser.finish(value2));
+					EXPECT_EQ_INT(parser.errorLine(), pushParser.errorLine());
+					EXPECT_EQ_INT(parser.errorColumn(), pushParser.errorColumn());
+					EXPECT_EQ_BOOL(true, value1 == value2);
+				}
+			}
+		}
+
+		// errors are found as soon as their chunk arrives, tokens cut by chunks wait for the rest
+		pushParser.setParseLFStyle(eCRLFAll);
+		JsonValue value;
+		EXPECT_EQ_INT(eOk, pushParser.feed("[\"abc", 5));
+		EXPECT_EQ_INT(eOk, pushParser.feed("\\", 1));
+		EXPECT_EQ_INT(eOk, pushParser.feed("\"\", tr", 6));
+		EXPECT_EQ_INT(eOk, pushParser.feed("ue, 12", 6));
+		EXPECT_EQ_INT(eOk, pushParser.feed("34]", 3));
+		EXPECT_EQ_INT(eOk, pushParser.finish(value));
+		EXPECT_EQ_STRING("abc\""s, value[0].getString());
+		EXPECT_EQ_BOOL(true, value[1].isTrue() && value[2].getInt64() == 1234);
+		EXPECT_EQ_INT(eOk, pushParser.feed("{\"a\" :\n", 7));
+		EXPECT_EQ_INT(eInvalidValue, pushParser.feed(" x,", 3));
+		EXPECT_EQ_INT(eInvalidValue, pushParser.feed("1}", 2));
+		EXPECT_EQ_INT(eInvalidValue, pushParser.finish(value));
+		EXPECT_EQ_INT(2, pushParser.errorLine());
+		EXPECT_EQ_INT(2, pushParser.errorColumn());
+		EXPECT_EQ_BOOL(true, value.isNull());
+		EXPECT_EQ_INT(eExpectValue, pushParser.finish(value));
+		EXPECT_EQ_INT(eOk, pushParser.feed("  0 ", 4));
+		EXPECT_EQ_INT(eOk, pushParser.finish(value));
+		EXPECT_EQ_BOOL(true, value.getInt64() == 0);
+	}
+
+	// records of JSON lines parsed on threads give the values and errors of parsing each line alone, in order
+	{
+		std::string text;
+		std::vector<std::string> lines;
+		unsigned int seed = 99;
+		for (int i = 0; i < 3000; i++)
+		{
+			seed = seed * 1103515245 + 12345;
+			std::string line = "{\"id\" : " + std::to_string(i) + ", \"msg\" : \"GET /item?id=" + std::to_string(seed % 1000) + "\", \"tags\" : [1, true, null]}";
+			if (seed % 7 == 0) // broken records
+				line[(seed >> 8) % line.size()] = ",]}\\"[(seed >> 4) % 4];
+			if (seed % 11 == 0) // blank lines are not records
+				line = (seed >> 8) % 2 ? "" : " \t";
+			lines.push_back(line);
+			text += line + ((seed >> 12) % 2 ? "\r\n" : "\n");
+		}
+		text.pop_back(); // the last line has no line break
+
+		for (unsigned int threads : { 1u, 4u })
+		{
+			JsonLinesParser linesParser(threads);
+			EXPECT_EQ_INT(threads, linesParser.threadCount());
+			std::vector<JsonValue> values;
+			std::vector<JsonLineResult> results;
+			size_t failed = linesParser.parse(text, values, results);
+			EXPECT_EQ_SIZE_T(values.size(), results.size());
+
+			JsonParser parser;
+			size_t record = 0, expectFailed = 0;
+			for (size_t i = 0; i < lines.size(); i++)
+			{
+				if (lines[i].find_first_not_of(" \t") == std::string::npos)
+					continue;
+				JsonValue value;
+				std::string errInfo;
+				int ret = parser.parseJson(value, lines[i], errInfo);
+				expectFailed += ret != eOk;
+				EXPECT_EQ_INT(ret, results[record].result);
+				EXPECT_EQ_INT(int(i + 1), results[record].line);
+				EXPECT_EQ_INT(parser.errorColumn(), results[record].column);
+				EXPECT_EQ_BOOL(true, value == values[record]);
+				record++;
+			}
+			EXPECT_EQ_SIZE_T(record, values.size());
+			EXPECT_EQ_SIZE_T(expectFailed, failed);
+			EXPECT_EQ_BOOL(true, failed > 0);
+
+			EXPECT_EQ_SIZE_T(0, linesParser.parse("\n \r\n", values, results));
+			EXPECT_EQ_SIZE_T(0, values.size());
+		}
+	}
+
+	// a large root array parsed on threads gives the value, error and position of JsonParser
+	{
+		std::string base = "\r\n [";
+		for (int i = 0; i < 2000; i++)
+			base += (i ? ",\n\t"s : ""s) + "{\"id\" : " + std::to_string(i) + ", \"s\" : \"a,]\\\"[}\", \"a\" : [[" + std::to_string(i % 7) + "], {}, null]}";
+		base += " ]\n";
+		EXPECT_EQ_BOOL(true, base.size() > JsonArrayParser::kMinParallelSize);
+		JsonParser parser;
+		for (unsigned int threads : { 1u, 3u })
+		{
+			JsonArrayParser arrayParser(threads);
+			EXPECT_EQ_INT(threads, arrayParser.threadCount());
+			JsonValue value1, value2;
+			EXPECT_EQ_INT(eOk, parser.parseJson(value1, base));
+			EXPECT_EQ_INT(eOk, arrayParser.parseJson(value2, base));
+			EXPECT_EQ_SIZE_T(2000, value2.size());
+			EXPECT_EQ_BOOL(true, value1 == value2);
+			EXPECT_EQ_INT(0, arrayParser.errorLine());
+
+			const char mutations[] = { ' ', '\"', '\\', '[', ']', '{', '}', ',', ':', 'x', '\0' };
+			unsigned int seed = 3;
+			for (int n = 0; n < 100; n++)
+			{
+				seed = seed * 1103515245 + 12345;
+				std::string json = base;
+				json[(seed >> 4) % json.size()] = mutations[(seed >> 20) % sizeof(mutations)];
+				std::string errInfo1, errInfo2;
+				EXPECT_EQ_INT(parser.parseJson(value1, json, errInfo1), arrayParser.parseJson(value2, json, errInfo2));
+				EXPECT_EQ_STRING(errInfo1, errInfo2);
+				EXPECT_EQ_INT(parser.errorLine(), arrayParser.errorLine());
+				EXPECT_EQ_INT(parser.errorColumn(), arrayParser.errorColumn());
+				EXPECT_EQ_BOOL(true, value1 == value2);
+			}
+
+			// elements nested deeper than the limit
+			arrayParser.setMaxDepth(3);
+			parser.setMaxDepth(3);
+			std::string errInfo1, errInfo2;
+			EXPECT_EQ_INT(eNestingTooDeep, parser.parseJson(value1, base, errInfo1));
+			EXPECT_EQ_INT(eNestingTooDeep, arrayParser.parseJson(value2, base, errInfo2));
+			EXPECT_EQ_STRING(errInfo1, errInfo2);
+			arrayParser.setMaxDepth(0);
+			EXPECT_EQ_INT(eNestingTooDeep, arrayParser.parseJson(value2, base));
+			arrayParser.setMaxDepth(JsonParser::kDefaultMaxDepth);
+			parser.setMaxDepth(JsonParser::kDefaultMaxDepth);
+
+			// other roots and small texts
+			EXPECT_EQ_INT(eOk, arrayParser.parseJson(value2, "{\"a\" : " + base + "}"));
+			EXPECT_EQ_SIZE_T(2000, value2["a"s].size());
+			EXPECT_EQ_INT(eRootNotSingular, arrayParser.parseJson(value2, base + "[]"));
+			EXPECT_EQ_INT(eOk, arrayParser.parseJson(value2, "[1, 2]"));
+			EXPECT_EQ_SIZE_T(2, value2.size());
+		}
+	}
+
+	// a mapped file gives the value and error of the same text in a string, also when it fills whole pages
+	{
+		const char* path = "parse_file_test.json";
+		JsonParser parser;
+		parser.setBorrowStrings(true);
+		for (ParseEngine engine : { eRecursiveEngine, eStructuralIndexEngine, eIterativeEngine })
+		{
+			parser.setParseEngine(engine);
+			for (size_t size : { 0, 1, 4095, 4096, 4097, 8192, 65536 })
+			{
+				for (std::string tail : { "12345"s, "[\"s\", 1.5e3, {\"k\" : true}]"s, "[1, 2"s, "\"abc"s })
+				{
+					std::string json = tail.size() <= size ? std::string(size - tail.size(), ' ') + tail : tail.substr(0, size);
+					for (size_t i = 0; i + 64 < json.size(); i += 61)
+						json[i] = '\n';
+					std::ofstream(path, std::ios::binary) << json;
+					JsonValue value1, value2;
+					std::string errInfo1, errInfo2;
+					EXPECT_EQ_INT(parser.parseJson(value1, json, errInfo1), parser.parseFile(value2, path, errInfo2));
+					EXPECT_EQ_STRING(errInfo1, errInfo2);
+					EXPECT_EQ_BOOL(true, value1 == value2);
+					if (value2.isArray()) // borrowing would refer to the mapping
+						EXPECT_EQ_BOOL(false, value2[0].isBorrowedString());
+				}
+			}
+		}
+		remove(path);
+		JsonValue value;
+		std::string errInfo;
+		EXPECT_EQ_INT(eFileError, parser.parseFile(value, path, errInfo));
+		EXPECT_EQ_STRING("Can not read the file."s, errInfo);
+		EXPECT_EQ_INT(0, parser.errorLine());
+		EXPECT_EQ_INT(eFileError, parser.parseFile(value, "."));
+		EXPECT_EQ_BOOL(true, value.isNull());
+	}
+
+	// borrowing strings gives the same value and error, strings without escapes and keys refer to the text
+	{
+		std::string base = "{\"plain\" : [\"a\", \"\", \"esc\\naped\"], \"k\\t\" : {\"\" : \"" + std::string(100, 'z') + "\"}, \"n\" : 1}";
+		const char mutations[] = { ' ', '\"', '\\', '[', ']', '{', '}', ',', ':', '\0' };
+		JsonParser copying, borrowing;
+		borrowing.setBorrowStrings(true);
+		for (ParseEngine engine : { eRecursiveEngine, eStructuralIndexEngine })
+		{
+			copying.setParseEngine(engine);
+			borrowing.setParseEngine(engine);
+			for (size_t i = 0; i <= base.size(); i++)
+			{
+				for (char ch : mutations)
+				{
+					std::string json = base;
+					if (i < base.size())
+						json[i] = ch;
+					else
+						json += ch;
+					JsonValue value1, value2;
+					std::string errInfo1, errInfo2;
+					EXPECT_EQ_INT(copying.parseJson(value1, json, errInfo1), borrowing.parseJson(value2, json, errInfo2));
+					EXPECT_EQ_STRING(errInfo1, errInfo2);
+					EXPECT_EQ_BOOL(true, value1 == value2);
+				}
+			}
+			auto inText = [&](std::string_view str) { return str.data() >= base.data() && str.data() + str.size() <= base.data() + base.size(); };
+			JsonValue value;
+			EXPECT_EQ_INT(eOk, borrowing.parseJson(value, base));
+			const JsonValue& array = value.get("plain");
+			EXPECT_EQ_BOOL(true, array[0].isBorrowedString() && inText(array[0].getStringView()));
+			EXPECT_EQ_BOOL(true, array[1].isBorrowedString() && array[1].getStringView().empty());
+			EXPECT_EQ_BOOL(false, array[2].isBorrowedString());
+			EXPECT_EQ_STRING("esc\naped"s, array[2].getString());
+			EXPECT_EQ_BOOL(true, value.get("k\t").get("").getStringView() == std::string(100, 'z'));
+			for (std::string_view key : value.getKeyViews())
+				EXPECT_EQ_BOOL(key != "k\t", inText(key));
+			JsonValue copied;
+			EXPECT_EQ_INT(eOk, copying.parseJson(copied, base));
+			std::string json1, json2;
+			JsonWriter writer(false);
+			writer.writeJson(copied, json1);
+			writer.writeJson(value, json2);
+			EXPECT_EQ_STRING(json1, json2);
+		}
+	}
+
+	// parsing into a document gives the same value and error, all memory comes from its arena
+	{
+		std::string base = "{\"a\" : [1, -2.5e3, true, null, \"x\\\"y\"], \"b\\u20AC\" : {\"c\" : [[], {}, [\"" + std::string(100, 'z') + "\"]]}}";
+		const char mutations[] = { ' ', '\"', '\\', '[', ']', '{', '}', ',', ':', '\0' };
+		CountingResource upstream;
+		JsonParser parser;
+		{
+			JsonDocument doc(256, &upstream);
+			for (size_t i = 0; i <= base.size(); i++)
+			{
+				for (char ch : mutations)
+				{
+					std::string json = base;
+					if (i < base.size())
+						json[i] = ch;
+					else
+						json += ch;
+					JsonValue value;
+					std::string errInfo1, errInfo2;
+					EXPECT_EQ_INT(parser.parseJson(value, json, errInfo1), parser.parseJson(doc, json, errInfo2));
+					EXPECT_EQ_STRING(errInfo1, errInfo2);
+					EXPECT_EQ_BOOL(true, value == doc.root());
+				}
+			}
+
+			// a document of many values still asks upstream for a few blocks only
+			std::string json = "[";
+			for (int i = 0; i < 1000; i++)
+				json += (i ? ", "s : ""s) + "{\"id\" : " + std::to_string(i) + ", \"tags\" : [\"x\\ty\", \"" + std::string(i % 50, 'w') + "\"]}";
+			json += "]";
+			doc.clear();
+			EXPECT_EQ_INT(0, upstream.outstanding);
+			upstream.allocations = 0;
+			EXPECT_EQ_INT(eOk, parser.parseJson(doc, json));
+			EXPECT_EQ_SIZE_T(1000, doc.root().size());
+			EXPECT_EQ_BOOL(true, upstream.allocations < 20);
+			EXPECT_EQ_BOOL(true, doc.root()[999]["tags"s][0].isBorrowedString());
+			EXPECT_EQ_STRING("x\ty"s, doc.root()[999]["tags"s][0].getString()); // a copy of the borrowed characters
+
+			// values added to the tree use the same arena
+			JsonValue array(eArray, doc.resource());
+			array.append(1);
+			array.append("two");
+			doc.mutableRoot().append(std::move(array));
+			EXPECT_EQ_SIZE_T(1001, doc.root().size());
+			EXPECT_EQ_BOOL(true, doc.root()[1000][1].getString() == "two");
+			doc.clear(); // "two" is on the heap, the tree is destroyed node by node
+			EXPECT_EQ_BOOL(true, doc.root().isNull());
+
+			// a parsed tree that is only read is dropped with the arena alone
+			EXPECT_EQ_INT(eOk, parser.parseJson(doc, json));
+			EXPECT_EQ_SIZE_T(1000, doc.root().size());
+			EXPECT_EQ_BOOL(true, doc.root()[999]["tags"s][0].getString() == "x\ty");
+			doc.clear();
+			EXPECT_EQ_INT(0, upstream.outstanding);
+			EXPECT_EQ_BOOL(true, doc.root().isNull());
+			EXPECT_EQ_INT(eOk, parser.parseJson(doc, json));
+		}
+		EXPECT_EQ_INT(0, upstream.outstanding);
+	}
+
+	// a view ends the text without a '\0': every prefix of a text parses as the same text in a string,
+	// from a buffer of exactly that size, and a '\0' inside the text is an error rather than its end
+	{
+		std::string base = "[\"a\\u20AC\\\"b\", -1.5e3, {\"k\" : [true, false, null]}, 123, \"" + std::string(40, 'z') + "\"]\r\n  \t ";
+		JsonParser parser;
+		for (ParseEngine engine : { eRecursiveEngine, eStructuralIndexEngine, eIterativeEngine })
+		{
+			parser.setParseEngine(engine);
+			for (size_t len = 0; len <= base.size(); len++)
+			{
+				std::string json = base.substr(0, len);
+				std::unique_ptr<char[]> exact(new char[len]); // no byte after the text for a scan to read
+				memcpy(exact.get(), base.data(), len);
+				JsonValue value1, value2, value3;
+				std::string errInfo1, errInfo2, errInfo3;
+				int ret = parser.parseJson(value1, json, errInfo1);
+				EXPECT_EQ_INT(ret, parser.parseJson(value2, std::string_view(base.data(), len), errInfo2));
+				EXPECT_EQ_STRING(errInfo1, errInfo2);
+				EXPECT_EQ_INT(ret, parser.parseJson(value3, exact.get(), len, errInfo3));
+				EXPECT_EQ_STRING(errInfo1, errInfo3);
+				EXPECT_EQ_BOOL(true, value1 == value2 && value1 == value3);
+				SumHandler handler1, handler2;
+				EXPECT_EQ_INT(parser.parseEvents(handler1, json), parser.parseEvents(handler2, std::string_view(base.data(), len)));
+				EXPECT_EQ_SIZE_T(handler1.values, handler2.values);
+			}
+			JsonValue value;
+			EXPECT_EQ_INT(eOk, parser.parseJson(value, "123456", 3));
+			EXPECT_EQ_BOOL(true, value.isInt64() && value.getInt64() == 123);
+			EXPECT_EQ_INT(eInvalidValue, parser.parseJson(value, "true", 3));
+			EXPECT_EQ_INT(eMissQuatationMark, parser.parseJson(value, "\"abc\"", 4));
+			EXPECT_EQ_INT(eInvalidUniCodeHex, parser.parseJson(value, "\"\\u0041\"", 6));
+			EXPECT_EQ_INT(eExpectValue, parser.parseJson(value, "   1", 3));
+			EXPECT_EQ_INT(eRootNotSingular, parser.parseJson(value, "[1]\0"s));
+			EXPECT_EQ_INT(eRootNotSingular, parser.parseJson(value, "1 \0 2"s));
+			EXPECT_EQ_INT(eInvalidValue, parser.parseJson(value, "[\0]"s));
+			EXPECT_EQ_INT(eInvalidStringChar, parser.parseJson(value, "\"a\0b\""s));
+			EXPECT_EQ_INT(eInvalidValue, parser.parseJson(value, "nul\0"s));
+		}
+	}
+
+	// lazy navigation reads the values JsonParser builds, and reports errors only on the way to what it reads
+	{
+		std::string json = " {\"user\" : {\"id\" : 12345678901234567890, \"name\" : \"a\\u20ACb\\n\", \"tags\" : [\"x\", [], {}, \"]}\\\"[{\"]},"
+			" \"skip\" : [[1, {\"k\" : \"}\"}], -0.0, 1.5e300, null, true, false],\r\n \"e\\u0073c\" : -12, \"\" : {\"deep\" : [[[\"end\"]]]}} ";
+		JsonParser parser;
+		JsonValue value;
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, json));
+		JsonLazyDocument doc(json);
+		test_lazy_value(value, doc.root());
+		EXPECT_EQ_BOOL(true, doc["user"]["id"].getUint64() == 12345678901234567890u);
+		EXPECT_EQ_BOOL(true, doc["user"]["name"].getStringView() == "a\xE2\x82\xAC" "b\n");
+		EXPECT_EQ_BOOL(true, doc["user"]["tags"][3].getStringView() == "]}\"[{");
+		EXPECT_EQ_BOOL(true, doc["user"]["tags"][0].getStringView().data() == json.data() + json.find("\"x\"") + 1); // no copy
+		EXPECT_EQ_BOOL(true, doc["esc"].getInt64() == -12);
+		EXPECT_EQ_BOOL(true, doc[""]["deep"][0][0][0].getString() == "end");
+
+		// values that are not there, and reads of another type
+		EXPECT_EQ_BOOL(false, doc["none"].exists());
+		EXPECT_EQ_BOOL(false, doc["none"]["id"][0].exists());
+		EXPECT_EQ_INT(eOk, doc["none"]["id"].result());
+		EXPECT_EQ_BOOL(false, doc[0].exists());
+		EXPECT_EQ_BOOL(false, doc["user"]["tags"][4].exists());
+		EXPECT_EQ_BOOL(true, doc["user"]["name"].getNumber() == 0 && doc["user"]["id"].getString().empty() && !doc["esc"].getBool());
+		EXPECT_EQ_BOOL(true, doc["esc"].getUint64() == 0 && doc["user"]["id"].getInt64() == 0);
+		EXPECT_EQ_SIZE_T(0, doc["esc"].size());
+		JsonValue parsed;
+		EXPECT_EQ_INT(eExpectValue, doc["none"].parse(parsed));
+
+		// the last of duplicate keys, as JsonValue keeps it
+		doc.reset("{\"a\" : 1, \"b\" : 2, \"a\" : [3]}");
+		EXPECT_EQ_BOOL(true, doc["a"].isArray() && doc["a"][0].getInt64() == 3);
+		EXPECT_EQ_SIZE_T(3, doc.root().size()); // members in the text
+
+		// errors on the way to a value, skipped values are not checked
+		doc.reset("{\"a\" : [1, 2 3], \"b\" : tru}");
+		EXPECT_EQ_BOOL(true, doc["a"].isArray());
+		EXPECT_EQ_INT(eArrayMissCommaOrSquareBracket, doc["a"][2].result());
+		EXPECT_EQ_BOOL(true, doc["a"][1].getInt64() == 2);
+		EXPECT_EQ_INT(eInvalidValue, doc["b"].parse(parsed));
+		EXPECT_EQ_BOOL(false, doc["b"].getBool());
+		doc.reset("{\"c\" : 1,}"); // a member is found once the whole object is read
+		EXPECT_EQ_INT(eObjectMissKey, doc["c"].result());
+		EXPECT_EQ_BOOL(false, doc["c"]["x"].exists());
+		EXPECT_EQ_INT(eObjectMissKey, doc["c"]["x"].result());
+		doc.reset("{\"a\" : \"x");
+		EXPECT_EQ_INT(eMissQuatationMark, doc["a"].result());
+		doc.reset("{\"a\" : [1, {\"x\" : \"]\"]");
+		EXPECT_EQ_INT(eArrayMissCommaOrSquareBracket, doc["b"].result());
+		doc.reset(" \r\n");
+		EXPECT_EQ_INT(eExpectValue, doc.root().result());
+		doc.reset("[1,]");
+		EXPECT_EQ_INT(eInvalidValue, doc[1].result());
+
+		// a scalar runs up to a delimiter, a read that fails keeps its error while another type leaves eOk
+		doc.reset("[\"\\q\", 12,7, 12abc, truex, \"x\"y]");
+		JsonCursor escape = doc[0];
+		EXPECT_EQ_BOOL(true, escape.getString().empty());
+		EXPECT_EQ_INT(eInvalidStringEscape, escape.result());
+		JsonCursor ok = doc[1];
+		EXPECT_EQ_BOOL(true, ok.getStringView().empty() && !ok.getBool() && ok.getUint64() == 12);
+		EXPECT_EQ_INT(eOk, ok.result()); // only of another type
+		EXPECT_EQ_BOOL(true, doc[2].getInt64() == 7);
+		JsonCursor n = doc[3];
+		EXPECT_EQ_INT(eOk, n.result());
+		EXPECT_EQ_BOOL(true, n.getInt64() == 0 && n.getNumber() == 0);
+		EXPECT_EQ_INT(eInvalidValue, n.result());
+		JsonCursor t = doc[4];
+		EXPECT_EQ_BOOL(false, t.getBool());
+		EXPECT_EQ_INT(eInvalidValue, t.result());
+		doc.reset("[\"x\"y]");
+		JsonCursor str = doc[0];
+		EXPECT_EQ_BOOL(true, str.getStringView().empty());
+		EXPECT_EQ_INT(eInvalidValue, str.result());
+		doc.reset("[7");
+		EXPECT_EQ_BOOL(true, doc[0].getInt64() == 7); // the end of the text ends it too
+		doc.reset("[12abc]");
+		EXPECT_EQ_INT(eInvalidValue, doc[0].parse(parsed));
+		EXPECT_EQ_BOOL(true, parsed.isNull());
+		doc.reset("12abc");
+		EXPECT_EQ_BOOL(true, doc.root().getInt64() == 0 && doc.root().type() == eNull);
+		doc.reset("[1]x");
+		EXPECT_EQ_INT(eInvalidValue, doc.root().parse(parsed));
+		doc.reset("-5");
+		EXPECT_EQ_BOOL(true, doc.root().getInt64() == -5);
+
+		// skipping long values whose brackets, quotes and backslashes fall on every offset of the 64 byte chunks
+		std::string big = "{\"skip\" : [";
+		for (int i = 0; i < 300; i++)
+			big += (i ? ", "s : ""s) + "{\"" + std::string(i % 67, 'k') + "\" : [\"" + std::string(i % 13, '\\') + std::string(i % 13, '\\') + "]\\\"}[\", {}], \"n\" : " + std::to_string(i) + "}";
+		big += "], \"after\" : \"found\"}";
+		JsonValue bigValue;
+		EXPECT_EQ_INT(eOk, parser.parseJson(bigValue, big));
+		doc.reset(big);
+		test_lazy_value(bigValue, doc.root());
+		EXPECT_EQ_BOOL(true, doc["after"].getString() == "found");
+		EXPECT_EQ_SIZE_T(300, doc["skip"].size());
+
+		// every prefix of the text: what exists reads as in a complete text, bounded by the end of the view
+		for (size_t len = 0; len < json.size(); len++)
+		{
+			doc.reset(std::string_view(json.data(), len));
+			JsonCursor name = doc["user"]["name"];
+			if (name.exists())
+				EXPECT_EQ_BOOL(true, name.getString().empty() || name.getString() == value["user"s]["name"s].getString());
+			EXPECT_EQ_BOOL(false, doc["esc"].exists() && doc["esc"].getInt64() != -12 && doc["esc"].getInt64() != -1);
+		}
+	}
+
+	// in-situ parsing gives the same value and error, strings are unescaped in the buffer
+	{
+		std::string base = "[\"plain\", \"a\\tb\\u20AC\\uD834\\uDD1E\\\"\", {\"k\\n\" : \"\\\\\", \"\" : [\"\", 1]}, \"" + std::string(100, 'z') + "\\/\"]";
+		const char mutations[] = { ' ', '\"', '\\', 'u', '[', ']', '{', '}', ',', ':', '\0' };
+		JsonParser parser;
+		for (size_t i = 0; i <= base.size(); i++)
+		{
+			for (char ch : mutations)
+			{
+				std::string json = base;
+				if (i < base.size())
+					json[i] = ch;
+				else
+					json += ch;
+				std::string buf = json;
+				JsonValue value1, value2;
+				EXPECT_EQ_INT(parser.parseJson(value1, json), parser.parseJsonInSitu(value2, &buf[0], buf.size()));
+				EXPECT_EQ_BOOL(true, value1 == value2);
+			}
+		}
+		// the buffer is not '\0' terminated, the parse stays inside len
+		for (std::string_view text : { "[\"a\\tb\"]", "\"abc", "\"ab\\", "-12.5e3", "[1,", "tru" })
+		{
+			std::unique_ptr<char[]> exact(new char[text.size()]);
+			std::copy(text.begin(), text.end(), exact.get());
+			JsonValue value1, value2;
+			EXPECT_EQ_INT(parser.parseJson(value1, text), parser.parseJsonInSitu(value2, exact.get(), text.size()));
+			EXPECT_EQ_BOOL(true, value1 == value2);
+		}
+		std::string buf = base;
+		const char* begin = buf.data();
+		const char* end = buf.data() + buf.size();
+		JsonValue value;
+		EXPECT_EQ_INT(eOk, parser.parseJsonInSitu(value, &buf[0], buf.size()));
+		EXPECT_EQ_BOOL(true, value[0].isBorrowedString() && value[1].isBorrowedString() && value[3].isBorrowedString());
+		EXPECT_EQ_BOOL(true, value[1].getStringView().data() >= begin && value[1].getStringView().data() < end);
+		EXPECT_EQ_BOOL(true, value[0].getStringView() == "plain");
+		EXPECT_EQ_STRING("plain"s, value[0].getString());
+		EXPECT_EQ_BOOL(true, value[1].getStringView() == "a\tb\xE2\x82\xAC\xF0\x9D\x84\x9E\"");
+		EXPECT_EQ_BOOL(true, value[2]["k\n"s].getStringView() == "\\");
+		for (std::string_view key : value[2].getKeyViews())
+			EXPECT_EQ_BOOL(true, key.data() >= begin && key.data() < end);
+		EXPECT_EQ_BOOL(true, value[3].getStringView() == std::string(100, 'z') + "/");
+
+		// a copy still refers to the buffer, setString takes its own copy
+		JsonValue copy = value[0];
+		EXPECT_EQ_BOOL(true, copy.isBorrowedString() && copy.getStringView().data() == value[0].getStringView().data());
+		copy.setString(std::string(copy.getStringView()));
+		EXPECT_EQ_STRING("plain"s, copy.getString());
+		EXPECT_EQ_BOOL(false, copy.isBorrowedString());
+		EXPECT_EQ_BOOL(true, copy == value[0]);
+	}
+
+	// children are built in place and moved up, so every input byte is copied once however deep it is
+	{
+		const int depth = 500;
+		std::string leaf(1000, 'x');
+		std::string json = std::string(depth, '[') + "\"" + leaf + "\"" + std::string(depth, ']');
+		JsonParser parser;
+		JsonValue value;
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, json)); // warm up the parser's buffers
+		value.setNull();
+		start_heap_counting();
+		int ret = parser.parseJson(value, json);
+		stop_heap_counting();
+		EXPECT_EQ_INT(eOk, ret);
+		EXPECT_EQ_BOOL(true, heap_bytes < leaf.size() + 1 + depth * 64);
+
+		const JsonValue* inner = &value;
+		for (int i = 0; i < depth; i++)
+			inner = &(*inner)[0];
+		EXPECT_EQ_BOOL(true, inner->getStringView() == leaf);
+
+		// one allocation per string and per container, keys and values are moved into objects
+		json = "[";
+		for (int i = 0; i < 100; i++)
+			json += (i ? ","s : ""s) + "{\"key" + std::to_string(i) + "\":\"" + std::string(100, 'a' + i % 26) + "\"}";
+		json += "]";
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, json));
+		value.setNull();
+		start_heap_counting();
+		ret = parser.parseJson(value, json);
+		stop_heap_counting();
+		EXPECT_EQ_INT(eOk, ret);
+		EXPECT_EQ_BOOL(true, heap_allocations <= 2 + 100 * 3);
+		EXPECT_EQ_BOOL(true, heap_bytes < json.size() + 100 * 128);
+		EXPECT_EQ_BOOL(true, value[99]["key99"s].getString() == std::string(100, 'a' + 99 % 26));
+
+		// with borrowed strings a document parse does not touch the heap at all
+		JsonDocument doc(64 * 1024);
+		parser.setBorrowStrings(true);
+		EXPECT_EQ_INT(eOk, parser.parseJson(doc, json));
+		start_heap_counting();
+		ret = parser.parseJson(doc, json);
+		stop_heap_counting();
+		EXPECT_EQ_INT(eOk, ret);
+		EXPECT_EQ_SIZE_T(0, heap_allocations);
+		EXPECT_EQ_SIZE_T(100, doc.root().size());
+	}
+
+	// parsing into the value of the last parse reuses its storage, same shaped texts then need no allocation at all
+	{
+		auto message = [](int i) {
+			std::string json = "{\"id\": " + std::to_string(i) + ", \"name\": \"" + std::string(40, 'a' + i % 26) + "\", "
+				"\"text\": \"line\\n" + std::string(30, 'b') + "\\u20AC\", \"tags\": [\"" + std::string(20, 'c') + "\", [true, null], {}], \"wide\": {";
+			for (int j = 0; j < 20; j++) // past the scan limit, looked up by the hash index
+				json += "\"field" + std::to_string(j) + "\": [" + std::to_string(i * j) + ", \"" + std::string(16 + j, 'd') + "\"], ";
+			return json + "\"field0\": \"again\"}, \"empty\": \"\"}";
+		};
+		for (ParseEngine engine : { eRecursiveEngine, eStructuralIndexEngine, eIterativeEngine })
+		{
+			JsonParser parser, reference;
+			parser.setParseEngine(engine);
+			parser.setReuseValues(true);
+			JsonValue value, expected;
+			EXPECT_EQ_INT(eOk, parser.parseJson(value, message(0)));
+			EXPECT_EQ_INT(eOk, parser.parseJson(value, message(1)));
+			std::string json = message(2);
+			start_heap_counting();
+			int ret = parser.parseJson(value, json);
+			stop_heap_counting();
+			EXPECT_EQ_INT(eOk, ret);
+			EXPECT_EQ_SIZE_T(0, heap_allocations);
+			EXPECT_EQ_INT(eOk, reference.parseJson(expected, json));
+			EXPECT_EQ_BOOL(true, value == expected);
+			EXPECT_EQ_STRING("again"s, value["wide"s]["field0"s].getString());
+
+			// the storage taken by a parse that fails goes back too, also when the index engine hands over to the recursive one
+			std::string broken = message(3);
+			broken.pop_back();
+			EXPECT_EQ_INT(eObjectMissCommaOrCurlyBracket, parser.parseJson(value, broken));
+			start_heap_counting();
+			ret = parser.parseJson(value, broken);
+			stop_heap_counting();
+			EXPECT_EQ_INT(eObjectMissCommaOrCurlyBracket, ret);
+			EXPECT_EQ_SIZE_T(0, heap_allocations);
+			start_heap_counting();
+			ret = parser.parseJson(value, json);
+			stop_heap_counting();
+			EXPECT_EQ_INT(eOk, ret);
+			EXPECT_EQ_SIZE_T(0, heap_allocations);
+			EXPECT_EQ_BOOL(true, value == expected);
+		}
+
+		// any other shape, borrowed strings, errors and storage of other resources give the values of a fresh parser
+		const char* texts[] = { "[1, \"two\", [\"three\", {\"four\": \"4444444444444444444444\"}]]", "\"a string long enough for the heap\"",
+			"{\"a\": {\"b\": {\"c\": [[], [[\"deep\"]]]}}, \"a\": 1}", "[\"x\", \"y\"", "{}", "[[[[[[\"nested\"]]]]]]",
+			"{\"key\\twith escape\": [\"\\u0041\", \"plain text of some length\"]}", "null" };
+		JsonParser parser, reference;
+		parser.setReuseValues(true);
+		JsonValue value, expected;
+		for (int round = 0; round < 3; round++)
+		{
+			parser.setBorrowStrings(round == 1);
+			for (const char* text : texts)
+			{
+				int ret = reference.parseJson(expected, text);
+				EXPECT_EQ_INT(ret, parser.parseJson(value, text));
+				EXPECT_EQ_BOOL(true, value == expected);
+			}
+		}
+		JsonDocument doc;
+		value = JsonValue(eArray, doc.resource());
+		value.append(JsonValue(eObject, doc.resource()));
+		value[0]["k"s] = "a string long enough for the heap";
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, texts[0]));
+		EXPECT_EQ_INT(eOk, reference.parseJson(expected, texts[0]));
+		EXPECT_EQ_BOOL(true, value == expected);
+		std::string buf = texts[6];
+		EXPECT_EQ_INT(eOk, parser.parseJsonInSitu(value, &buf[0], buf.size()));
+		EXPECT_EQ_BOOL(true, value["key\twith escape"s][0].getStringView() == "A");
+		parser.setReuseValues(false);
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, texts[5]));
+		EXPECT_EQ_STRING("nested"s, value[0][0][0][0][0][0].getString());
+	}
+
+	// JSON Pointer, the examples of RFC 6901
+	{
+		JsonParser parser;
+		JsonValue value;
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, R"({"foo": ["bar", "baz"], "": 0, "a/b": 1, "c%d": 2, "e^f": 3, "g|h": 4,
+			"i\\j": 5, "k\"l": 6, " ": 7, "m~n": 8, "0": 9})"));
+		EXPECT_EQ_BOOL(true, JsonPointer("").resolve(value) == &value);
+		EXPECT_EQ_BOOL(true, JsonPointer().resolve(value) == &value);
+		EXPECT_EQ_BOOL(true, JsonPointer("/foo").resolve(value) == &value.get("foo"));
+		EXPECT_EQ_STRING("bar"s, JsonPointer("/foo/0").resolve(value)->getString());
+		EXPECT_EQ_STRING("baz"s, JsonPointer("/foo/1").resolve(value)->getString());
+		const char* pointers[] = { "/", "/a~1b", "/c%d", "/e^f", "/g|h", "/i\\j", "/k\"l", "/ ", "/m~0n", "/0" };
+		for (int i = 0; i < 10; i++)
+			EXPECT_EQ_BOOL(true, JsonPointer(pointers[i]).resolve(value)->getInt64() == i);
+		for (const char* absent : { "/foo/2", "/foo/-", "/foo/01", "/foo/+1", "/foo/18446744073709551616", "/bar", "/foo/0/x", "//" })
+			EXPECT_EQ_BOOL(true, JsonPointer(absent).resolve(value) == nullptr);
+		for (const char* invalid : { "foo", "#/foo", "/a~2b", "/m~", "/~~0" })
+		{
+			EXPECT_EQ_BOOL(false, JsonPointer(invalid).isValid());
+			EXPECT_EQ_BOOL(true, JsonPointer(invalid).resolve(value) == nullptr);
+		}
+		JsonPointer pointer("/a~1b/~0~1/");
+		EXPECT_EQ_BOOL(true, pointer.isValid());
+		EXPECT_EQ_SIZE_T(3, pointer.size());
+		EXPECT_EQ_BOOL(true, pointer.token(0) == "a/b" && pointer.token(1) == "~/" && pointer.token(2) == "");
+
+		// large objects are looked up through the hash index with the hashes of the pointer
+		JsonValue large;
+		for (int i = 0; i < 100; i++)
+			large["key"s + std::to_string(i)]["list"].append(i);
+		for (int i = 0; i < 100; i++)
+			EXPECT_EQ_BOOL(true, JsonPointer("/key" + std::to_string(i) + "/list/0").resolve(large)->getInt64() == i);
+		EXPECT_EQ_BOOL(true, JsonPointer("/key100").resolve(large) == nullptr);
+
+		// a compiled pointer does not allocate to resolve
+		JsonPointer compiled("/key42/list/0");
+		const JsonValue& constLarge = large;
+		EXPECT_EQ_BOOL(true, compiled.resolve(constLarge) != nullptr);
+		start_heap_counting();
+		const JsonValue* found = compiled.resolve(constLarge);
+		stop_heap_counting();
+		EXPECT_EQ_SIZE_T(0, heap_allocations);
+		EXPECT_EQ_BOOL(true, found->getInt64() == 42);
+		compiled.resolve(large)->setInt64(-42);
+		EXPECT_EQ_BOOL(true, large["key42"s]["list"s][0].getInt64() == -42);
+	}
+
+	// getString and getKeys read the strings of every parse mode, owned or borrowed
+	{
+		std::string json = "{\"plain key\": \"plain text\", \"escaped\\tkey\": \"escaped\\ntext\"}";
+		std::vector<std::string> keys = { "plain key", "escaped\tkey" };
+		JsonParser parser;
+		JsonValue owned, borrowed, inSitu;
+		EXPECT_EQ_INT(eOk, parser.parseJson(owned, json));
+		parser.setBorrowStrings(true);
+		EXPECT_EQ_INT(eOk, parser.parseJson(borrowed, json));
+		EXPECT_EQ_BOOL(true, borrowed["plain key"s].isBorrowedString());
+		parser.setBorrowStrings(false);
+		std::string buf = json;
+		EXPECT_EQ_INT(eOk, parser.parseJsonInSitu(inSitu, &buf[0], buf.size()));
+		JsonDocument doc;
+		EXPECT_EQ_INT(eOk, parser.parseJson(doc, json));
+		const JsonValue* values[] = { &owned, &borrowed, &inSitu, &doc.root() };
+		for (const JsonValue* value : values)
+		{
+			EXPECT_EQ_STRING("plain text"s, value->get("plain key").getString());
+			EXPECT_EQ_STRING("escaped\ntext"s, value->get("escaped\tkey").getString());
+			EXPECT_EQ_BOOL(true, value->getKeys() == keys);
+		}
+	}
+
+	// JSON Pointer creates what is missing
+	{
+		JsonValue value;
+		JsonValue* created = JsonPointer("/a/b/0/c").resolveOrCreate(value);
+		EXPECT_EQ_BOOL(true, created != nullptr && created->isNull());
+		created->setString("deep");
+		EXPECT_EQ_BOOL(true, value.isObject() && value["a"s]["b"s].isArray() && value["a"s]["b"s][0]["c"s].getString() == "deep");
+		EXPECT_EQ_BOOL(true, JsonPointer("/a/b/0/c").resolveOrCreate(value) == created);
+		JsonPointer("/a/b/-").resolveOrCreate(value)->setInt64(1);
+		JsonPointer("/a/b/2").resolveOrCreate(value)->setInt64(2);
+		EXPECT_EQ_BOOL(true, JsonPointer("/a/b/4").resolveOrCreate(value) == nullptr); // past the end, nothing is padded
+		EXPECT_EQ_BOOL(true, JsonPointer("/a/b/18446744073709551615").resolveOrCreate(value) == nullptr);
+		EXPECT_EQ_SIZE_T(3, value["a"s]["b"s].size());
+		EXPECT_EQ_BOOL(true, value["a"s]["b"s][1].getInt64() == 1 && value["a"s]["b"s][2].getInt64() == 2);
+		JsonPointer("/a/-/x").resolveOrCreate(value)->setBool(true);
+		EXPECT_EQ_BOOL(true, value["a"s]["-"s]["x"s].getBool());
+		JsonPointer("/list/-").resolveOrCreate(value);
+		EXPECT_EQ_BOOL(true, value["list"s].isArray() && value["list"s].size() == 1);
+		EXPECT_EQ_BOOL(true, JsonPointer("/a/b/x").resolveOrCreate(value) == nullptr); // not an index of an array
+		EXPECT_EQ_BOOL(true, JsonPointer("/a/b/1/x").resolveOrCreate(value) == nullptr); // in a number
+		EXPECT_EQ_BOOL(true, JsonPointer("a").resolveOrCreate(value) == nullptr);
+		EXPECT_EQ_BOOL(true, JsonPointer("").resolveOrCreate(value) == &value);
+		EXPECT_EQ_SIZE_T(2, value.size());
+
+		// the containers and keys created in a document allocate from its arena, starting from a null root
+		CountingResource upstream;
+		{
+			JsonDocument doc(1024, &upstream);
+			int allocations = upstream.allocations;
+			JsonPointer pointer("/a key too long for the small string buffer/x");
+			std::vector<JsonPointer> pointers;
+			for (int i = 0; i < 10; i++)
+				pointers.emplace_back("/x/" + std::to_string(i) + "/y");
+			start_heap_counting();
+			for (int i = 0; i < 10; i++)
+				pointers[i].resolveOrCreate(doc)->setInt64(i);
+			pointer.resolveOrCreate(doc)->setInt64(1);
+			stop_heap_counting();
+			EXPECT_EQ_SIZE_T(0, heap_allocations);
+			EXPECT_EQ_BOOL(true, upstream.allocations > allocations);
+			EXPECT_EQ_BOOL(true, doc.root().isObject());
+			EXPECT_EQ_BOOL(true, JsonPointer("/x/9/y").resolve(doc.root())->getInt64() == 9);
+			EXPECT_EQ_BOOL(true, pointer.resolve(doc.root())->getInt64() == 1);
+		}
+		EXPECT_EQ_INT(0, upstream.outstanding);
+
+		// under any other resource a key is owned and released with its object
+		CountingResource pool;
+		{
+			JsonValue object(eObject, &pool);
+			JsonPointer("/a key too long for the small string buffer/x").resolveOrCreate(object)->setInt64(1);
+			EXPECT_EQ_BOOL(false, object.getKeyViews().empty());
+		}
+		EXPECT_EQ_INT(0, pool.outstanding);
+	}
+
+	// JSON Pointers resolved together share the lookups of their common prefixes
+	{
+		std::string json = R"({"header": {"id": 7, "route": {"service": "orders", "method": "create"}, "tags": ["a", "b"]},
+			"body": {"items": [{"sku": "x1", "qty": 2}, {"sku": "x2", "qty": 5}]}})";
+		JsonParser parser;
+		JsonValue value;
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, json));
+		std::vector<std::string> paths = { "/header/route/service", "/header/route/method", "/header/id", "/header/tags/1",
+			"/body/items/1/qty", "/body/items/0/sku", "/header/route/service", "/header/missing/x", "/body/items/2/sku",
+			"", "/header", "bad", "/header/route" };
+		JsonPointerBatch batch;
+		for (size_t i = 0; i < paths.size(); i++)
+			EXPECT_EQ_SIZE_T(i, batch.add(paths[i]));
+		EXPECT_EQ_SIZE_T(paths.size(), batch.size());
+		std::vector<const JsonValue*> results;
+		batch.resolve(value, results);
+		EXPECT_EQ_SIZE_T(paths.size(), results.size());
+		for (size_t i = 0; i < paths.size(); i++)
+			EXPECT_EQ_BOOL(true, results[i] == JsonPointer(paths[i]).resolve(value));
+		EXPECT_EQ_STRING("orders"s, results[0]->getString());
+		EXPECT_EQ_BOOL(true, results[4]->getInt64() == 5);
+		EXPECT_EQ_BOOL(true, results[7] == nullptr && results[8] == nullptr && results[11] == nullptr);
+
+		start_heap_counting();
+		batch.resolve(value, results);
+		stop_heap_counting();
+		EXPECT_EQ_SIZE_T(0, heap_allocations);
+		EXPECT_EQ_BOOL(true, results[9] == &value);
+
+		JsonValue scalar(1);
+		batch.resolve(scalar, results);
+		EXPECT_EQ_BOOL(true, results[9] == &scalar && results[0] == nullptr);
+		batch.clear();
+		EXPECT_EQ_SIZE_T(0, batch.size());
+		batch.add(JsonPointer("/body/items/0/qty"));
+		batch.resolve(value, results);
+		EXPECT_EQ_BOOL(true, results.size() == 1 && results[0]->getInt64() == 2);
+	}
+
+	// UTF-8 of strings is checked in blocks, the error is at the first byte of the invalid sequence
+	{
+		const char* pieces[] = { "a", "\x7F", "\xC2\x80", "\xDF\xBF", "\xE0\xA0\x80", "\xE2\x82\xAC", "\xED\x9F\xBF", "\xEF\xBF\xBF",
+			"\xF0\x90\x80\x80", "\xF0\x9F\x98\x80", "\xF4\x8F\xBF\xBF", "0123456789abcdef" };
+		uint32_t seed = 12345;
+		auto next = [&seed]() { seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5; return seed; };
+		JsonParser parser;
+		JsonValue value;
+		std::string errInfo;
+		for (int round = 0; round < 3000; round++)
+		{
+			std::string str;
+			size_t length = next() % 160;
+			while (str.size() < length)
+				str += pieces[next() % 12];
+			if (round % 3 != 0 && !str.empty()) // break a byte somewhere
+				str[next() % str.size()] = char(0x80 + next() % 0x80);
+			if (round % 7 == 0 && !str.empty()) // or cut a sequence at the end
+				str.pop_back();
+			size_t invalid = first_invalid_utf8(str);
+			std::string json = "[\"" + str + "\"]";
+			int ret = parser.parseJson(value, json, errInfo);
+			EXPECT_EQ_INT(invalid == std::string::npos ? eOk : eInvalidUtf8, ret);
+			if (invalid == std::string::npos)
+				EXPECT_EQ_BOOL(true, value[0].getStringView() == str);
+			else
+				EXPECT_EQ_INT(int(invalid) + 3, parser.errorColumn());
+			// a run before an escape, and a borrowed string without one
+			json = "\"" + str + "\\t\"";
+			EXPECT_EQ_INT(ret, parser.parseJson(value, json));
+			parser.setBorrowStrings(true);
+			EXPECT_EQ_INT(ret, parser.parseJson(value, "\"" + str + "\""));
+			parser.setBorrowStrings(false);
+		}
+
+		std::string json = "{\"key\": \"text \xE2\x82\xAC\xE2\x82\n\"}";
+		EXPECT_EQ_INT(eInvalidUtf8, parser.parseJson(value, json, errInfo));
+		EXPECT_EQ_STRING("line 1, column 18: Invalid UTF-8 in string."s, errInfo);
+		EXPECT_EQ_INT(eInvalidUtf8, parser.validate(json));
+		JsonLazyDocument doc(json);
+		EXPECT_EQ_INT(eInvalidUtf8, doc["key"].parse(value));
+		JsonPushParser pushParser;
+		for (char ch : json)
+			pushParser.feed(&ch, 1);
+		EXPECT_EQ_INT(eInvalidUtf8, pushParser.finish(value));
+		EXPECT_EQ_INT(18, pushParser.errorColumn());
+
+		// off for text in other 8 bit encodings, the bytes are kept
+		parser.setValidateUtf8(false);
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, "[\"caf\xE9\", \"\xFF\"]"));
+		EXPECT_EQ_BOOL(true, value[0].getStringView() == "caf\xE9" && value[1].getStringView() == "\xFF");
+		EXPECT_EQ_INT(eOk, parser.validate("\"\xC0\xAF\""));
+		EXPECT_EQ_INT(eInvalidStringChar, parser.parseJson(value, "\"\xE9\x01\""));
+	}
+
+	// validation gives the result and position of parseJson without building anything
+	{
+		JsonParser parser;
+		JsonValue value;
+		std::string parseLoc, validateLoc;
+		const char* numbers[] = { "1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308", "-1.8e308",
+			"17976931348623157e292", "0.0000000000000000000000000000001e339", "1e309", "0e99999", "1e-99999", "0.1e309",
+			"100000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+			"000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+			"00000000000000000000000000000000000000000000000000000000000000000000", // 10^308
+			"100000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+			"000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+			"000000000000000000000000000000000000000000000000000000000000000000000" }; // 10^309
+		for (const char* number : numbers)
+		{
+			std::string json = "[1, "s + number + "]";
+			EXPECT_EQ_INT(parser.parseJson(value, json, parseLoc), parser.validate(json, validateLoc));
+			EXPECT_EQ_STRING(parseLoc, validateLoc);
+		}
+		EXPECT_EQ_INT(eNumberTooBig, parser.validate("1.7976931348623159e308"));
+		EXPECT_EQ_INT(eOk, parser.validate("1.7976931348623158e308"));
+
+		// line and column with each line feed style, nesting limit from the root
+		std::string json = "{\r\n\"a\": [1,\n\r 2,\r\r{\"b\": [tru]}]}";
+		for (LFStyle style : { eCR, eLF, eCRLF, eCRLFAll })
+		{
+			parser.setParseLFStyle(style);
+			EXPECT_EQ_INT(eInvalidValue, parser.parseJson(value, json, parseLoc));
+			int line = parser.errorLine(), column = parser.errorColumn();
+			EXPECT_EQ_INT(eInvalidValue, parser.validate(json, validateLoc));
+			EXPECT_EQ_STRING(parseLoc, validateLoc);
+			EXPECT_EQ_INT(line, parser.errorLine());
+			EXPECT_EQ_INT(column, parser.errorColumn());
+		}
+		parser.setParseLFStyle(eCRLFAll);
+		parser.setMaxDepth(3);
+		EXPECT_EQ_INT(eOk, parser.validate("[[[1]], {\"a\": []}]"));
+		EXPECT_EQ_INT(eNestingTooDeep, parser.validate("[[[[1]]]]", validateLoc));
+		EXPECT_EQ_INT(eNestingTooDeep, parser.parseJson(value, "[[[[1]]]]", parseLoc));
+		EXPECT_EQ_STRING(parseLoc, validateLoc);
+
+		// an explicit stack, any depth the limit allows, and nothing allocated on the heap
+		const int depth = 100000;
+		parser.setMaxDepth(depth);
+		json = std::string(depth, '[') + std::string(depth, ']');
+		EXPECT_EQ_INT(eOk, parser.validate(json)); // warm up the stack
+		json = "{\"list\": [" + std::string(300, '1') + ", -0.5e-3, \"\\ud83d\\ude00\\n\", true, null, false, {}, []], \"k\\t\": {\"x\": \"y\"}}";
+		start_heap_counting();
+		int ret = parser.validate(json);
+		stop_heap_counting();
+		EXPECT_EQ_INT(eOk, ret);
+		EXPECT_EQ_SIZE_T(0, heap_allocations);
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, json));
+	}
+
+	// path projection builds the values of the paths and the containers on the way to them
+	{
+		std::string json = R"({"id": 7, "name": "event", "skip": {"deep": [1, 2, {"x": "\u0041\n"}], "n": -1.5e3},
+			"items": [{"sku": "x1", "qty": 2}, "s", {"sku": "x2", "qty": 5, "extra": [true, null]}, 4, 5],
+			"meta": {"route": {"service": "orders"}, "tags": ["a", "b"]}, "dup": 1, "dup": {"v": 2}, "n": 1})";
+		JsonParser parser;
+		JsonValue full;
+		EXPECT_EQ_INT(eOk, parser.parseJson(full, json));
+		JsonPointerBatch paths;
+		for (const char* path : { "/id", "/items/2/qty", "/items/0", "/meta/route/service", "/dup/v", "/missing/x", "/name/x", "/items/9", "/meta/tags/0" })
+			paths.add(path);
+		parser.setProjection(&paths);
+		JsonValue value;
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, json));
+		std::vector<const JsonValue*> projected, expected;
+		paths.resolve(value, projected);
+		paths.resolve(full, expected);
+		for (size_t i = 0; i < paths.size(); i++)
+			EXPECT_EQ_BOOL(true, (projected[i] == nullptr && expected[i] == nullptr) || (projected[i] && expected[i] && *projected[i] == *expected[i]));
+		std::vector<std::string_view> keys = value.getKeyViews();
+		EXPECT_EQ_BOOL(true, keys == std::vector<std::string_view>({ "id", "items", "meta", "dup" }));
+		EXPECT_EQ_SIZE_T(5, value["items"s].size()); // nulls up to the largest index
+		EXPECT_EQ_BOOL(true, value["items"s][1].isNull() && value["items"s][2].size() == 1 && value["items"s][4].isNull());
+		EXPECT_EQ_SIZE_T(2, value["meta"s].size());
+		EXPECT_EQ_SIZE_T(1, value["meta"s]["tags"s].size()); // none after the largest index
+
+		// a whole subtree, the root, nothing, and a scalar on the way that replaces a duplicate
+		JsonPointerBatch subtree;
+		subtree.add("/skip");
+		parser.setProjection(&subtree);
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, json));
+		EXPECT_EQ_BOOL(true, value.size() == 1 && value["skip"s] == full["skip"s]);
+		JsonPointerBatch root;
+		root.add("/id");
+		root.add("");
+		parser.setProjection(&root);
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, json));
+		EXPECT_EQ_BOOL(true, value == full);
+		JsonPointerBatch none;
+		parser.setProjection(&none);
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, json));
+		EXPECT_EQ_BOOL(true, value.isObject() && value.empty());
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, "[1, 2]"));
+		EXPECT_EQ_BOOL(true, value.isArray() && value.empty());
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, " 1 "));
+		EXPECT_EQ_BOOL(true, value.isNull());
+		JsonPointerBatch duplicate;
+		duplicate.add("/a/b");
+		parser.setProjection(&duplicate);
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, R"({"a": {"b": 1}, "a": 2})"));
+		EXPECT_EQ_BOOL(true, value.isObject() && value.empty());
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, R"({"a": 2, "a": {"b": 1, "c": 3}})"));
+		EXPECT_EQ_BOOL(true, value["a"s].size() == 1 && value["a"s]["b"s].getInt64() == 1);
+
+		// the skipped values are checked: the same result and position as a full parse
+		const char* invalid[] = { "", " ", "{\"skip\": [1, 2,]}", "{\"skip\": {\"a\" 1}}", "{\"skip\": \"\\x\"}", "{\"skip\": 01}",
+			"{\"skip\": [1e400]}", "{\"a\": {\"b\": 1 \"c\": 2}}", "{\"a\": [1 2]}", "{\"a\": {\"b\": tru}}", "{\"skip\": 1} x",
+			"{\"a\": {\"b\": [1, 2}}", "{\"a\": 1, }", "{\"a\": [[[[1]]]]}", "{\"skip\": [[[[1]]]]}", "[0, [1, [2, [3, [4]]]]]" };
+		JsonPointerBatch some;
+		some.add("/a/b");
+		some.add("/1/1/0");
+		JsonParser reference;
+		reference.setMaxDepth(4);
+		parser.setMaxDepth(4);
+		parser.setProjection(&some);
+		for (const char* text : invalid)
+		{
+			int expect = reference.parseJson(full, text);
+			EXPECT_EQ_BOOL(true, expect != eOk);
+			value = JsonValue("not cleared");
+			EXPECT_EQ_INT(expect, parser.parseJson(value, text));
+			EXPECT_EQ_INT(reference.errorLine(), parser.errorLine());
+			EXPECT_EQ_INT(reference.errorColumn(), parser.errorColumn());
+			EXPECT_EQ_BOOL(true, value.isNull());
+		}
+		parser.setMaxDepth(JsonParser::kDefaultMaxDepth);
+
+		// the skipped members are not built
+		std::string large = "[";
+		for (int i = 0; i < 100; i++)
+		{
+			large += i ? ", {" : "{";
+			for (int j = 0; j < 50; j++)
+				large += "\"field" + std::to_string(j) + "\": \"" + std::string(40, 'a' + j % 26) + "\\n\", ";
+			large += "\"id\": " + std::to_string(i) + "}";
+		}
+		large += "]";
+		JsonPointerBatch ids;
+		ids.add("/99/id");
+		ids.add("/50/field7");
+		parser.setProjection(&ids);
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, large)); // warm up the parser's buffers
+		value.setNull();
+		start_heap_counting();
+		int ret = parser.parseJson(value, large);
+		stop_heap_counting();
+		EXPECT_EQ_INT(eOk, ret);
+		EXPECT_EQ_BOOL(true, heap_allocations < 10);
+		EXPECT_EQ_SIZE_T(100, value.size());
+		EXPECT_EQ_BOOL(true, value[99]["id"s].getInt64() == 99 && value[98].isNull());
+		EXPECT_EQ_BOOL(true, value[50]["field7"s].getString() == std::string(40, 'h') + "\n");
+
+		// into a document, and with the index engine, which a projection does not use
+		JsonDocument doc;
+		parser.setParseEngine(eStructuralIndexEngine);
+		EXPECT_EQ_INT(eOk, parser.parseJson(doc, large));
+		EXPECT_EQ_BOOL(true, doc.root().size() == 100 && doc.root()[99]["id"s].getInt64() == 99);
+		parser.setProjection(NULL);
+		EXPECT_EQ_INT(eOk, parser.parseJson(value, large));
+		EXPECT_EQ_BOOL(true, value[98]["field0"s].isString());
 	}
 
 	// support parsing comment, not implement yet
@@ -652,6 +2385,11 @@ static void test_api()
 int main()
 {
 	test_parse();
+	test_engine = eStructuralIndexEngine;
+	test_parse();
+	test_engine = eIterativeEngine;
+	test_parse();
+	test_engine = eRecursiveEngine;
 	test_access();
 	test_write();
 	test_api();